@@ -0,0 +1,184 @@
+#ifndef _ADMISSION_HPP_
+#define _ADMISSION_HPP_ 1
+
+#include <memory>
+#include <atomic>
+#include <chrono>
+#include <algorithm>
+#include <cstdint>
+#include "nocopy.hpp"
+
+inline const int default_admission_bits = 16; // 计数表大小为2^16项
+
+/**
+ * @brief 按来源IP的准入配置，各项为0表示不限制
+ */
+struct AdmissionOpts
+{
+    uint32_t max_conns_per_ip = 0; // 单个IP同时保持的连接数上限
+    double conn_rate = 0;          // 单个IP每秒新建连接数
+    double conn_burst = 0;         // 新建连接的突发量，0表示等于conn_rate
+    double req_rate = 0;           // 单个IP每秒请求数
+    double req_burst = 0;          // 请求的突发量，0表示等于req_rate
+    int bits = default_admission_bits; // 计数表大小（2的幂次）
+};
+
+// 准入统计（累计值）
+struct AdmissionStats
+{
+    uint64_t admitted;          // 放行的连接数
+    uint64_t rejected_conns;    // 因连接数上限拒绝的连接
+    uint64_t rejected_rate;     // 因新建速率拒绝的连接
+    uint64_t rejected_requests; // 因请求速率拒绝的请求
+};
+
+/**
+ * @brief 按来源IP的准入控制
+ * @note IP经哈希映射到固定大小的计数表，每项为一个连接计数和两个令牌桶，
+ *       全部为无锁原子操作，监听线程与各工作线程共享同一个实例。
+ *       哈希冲突的IP共用计数，只会让限制更严格而不会放宽。
+ *       令牌桶用GCRA实现：每个桶只保存一个“理论到达时间”，不需要后台补充令牌
+ */
+class AdmissionControl : public nocopy
+{
+public:
+    explicit AdmissionControl(const AdmissionOpts &opts)
+        : opts_(opts),
+          shift_(32 - opts.bits),
+          slots_(new Slot[(size_t)1 << opts.bits]),
+          conn_bucket_(opts.conn_rate, opts.conn_burst),
+          req_bucket_(opts.req_rate, opts.req_burst)
+    {
+    }
+
+    /**
+     * @brief 新连接准入检查（accept后立即调用）
+     * @param ip 对端IPv4地址（网络字节序）
+     * @return 放行返回true，此后连接关闭时须调用ReleaseConnection
+     */
+    bool AdmitConnection(uint32_t ip)
+    {
+        Slot &slot = SlotOf(ip);
+        if (!conn_bucket_.Take(slot.conn_tat, 1))
+        {
+            stats_.rejected_rate.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        uint32_t conns = slot.conns.fetch_add(1, std::memory_order_relaxed);
+        if (opts_.max_conns_per_ip && conns >= opts_.max_conns_per_ip)
+        {
+            slot.conns.fetch_sub(1, std::memory_order_relaxed);
+            stats_.rejected_conns.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        stats_.admitted.fetch_add(1, std::memory_order_relaxed);
+        return true;
+    }
+
+    /// 已放行的连接关闭
+    void ReleaseConnection(uint32_t ip)
+    {
+        std::atomic<uint32_t> &conns = SlotOf(ip).conns;
+        uint32_t cur = conns.load(std::memory_order_relaxed);
+        while (cur > 0 && !conns.compare_exchange_weak(cur, cur - 1, std::memory_order_relaxed));
+    }
+
+    /**
+     * @brief 请求准入检查（解码后、求值前调用）
+     * @param n 本批解码出的请求数
+     * @return 放行的请求数：按帧依次扣减令牌，遇到第一个不足时停止，
+     *         因此超过突发量的一批请求仍能放行桶内剩余的部分
+     */
+    size_t AdmitRequests(uint32_t ip, size_t n)
+    {
+        size_t admitted = req_bucket_.TakeUpTo(SlotOf(ip).req_tat, n);
+        if (admitted < n) stats_.rejected_requests.fetch_add(n - admitted, std::memory_order_relaxed);
+        return admitted;
+    }
+
+    /// 某IP当前的连接数（与其哈希冲突的IP合计）
+    uint32_t Connections(uint32_t ip) { return SlotOf(ip).conns.load(std::memory_order_relaxed); }
+
+    /// 统计快照（可跨线程读取）
+    AdmissionStats Stats()
+    {
+        return {stats_.admitted.load(std::memory_order_relaxed),
+                stats_.rejected_conns.load(std::memory_order_relaxed),
+                stats_.rejected_rate.load(std::memory_order_relaxed),
+                stats_.rejected_requests.load(std::memory_order_relaxed)};
+    }
+
+private:
+    struct Slot
+    {
+        std::atomic<uint32_t> conns{0};   // 当前连接数
+        std::atomic<int64_t> conn_tat{0}; // 新建连接令牌桶的理论到达时间（纳秒）
+        std::atomic<int64_t> req_tat{0};  // 请求令牌桶的理论到达时间（纳秒）
+    };
+
+    // GCRA令牌桶参数：每个令牌的间隔与允许的最大提前量
+    class Bucket
+    {
+    public:
+        Bucket(double rate, double burst)
+            : interval_(rate > 0 ? (int64_t)(1e9 / rate) : 0),
+              tolerance_((int64_t)((burst > 0 ? burst : rate) * (rate > 0 ? 1e9 / rate : 0)))
+        {
+        }
+
+        // 从桶中取n个令牌，不足时不扣减并返回false
+        bool Take(std::atomic<int64_t> &tat, size_t n)
+        {
+            if (interval_ == 0) return true; // 未限速
+            int64_t now = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now().time_since_epoch()).count();
+            int64_t cur = tat.load(std::memory_order_relaxed);
+            while (true)
+            {
+                int64_t next = (cur > now ? cur : now) + (int64_t)n * interval_;
+                if (next - now > tolerance_) return false;
+                if (tat.compare_exchange_weak(cur, next, std::memory_order_relaxed)) return true;
+            }
+        }
+
+        // 取至多n个令牌，返回实际取到的个数（一次CAS完成，等价于逐个取到第一次失败为止）
+        size_t TakeUpTo(std::atomic<int64_t> &tat, size_t n)
+        {
+            if (interval_ == 0) return n; // 未限速
+            int64_t now = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now().time_since_epoch()).count();
+            int64_t cur = tat.load(std::memory_order_relaxed);
+            while (true)
+            {
+                int64_t base = cur > now ? cur : now;
+                int64_t room = tolerance_ - (base - now); // 桶内剩余令牌对应的时间
+                size_t k = room < interval_ ? 0 : std::min(n, (size_t)(room / interval_));
+                if (k == 0) return 0;
+                if (tat.compare_exchange_weak(cur, base + (int64_t)k * interval_, std::memory_order_relaxed)) return k;
+            }
+        }
+
+    private:
+        int64_t interval_;  // 每个令牌的时间间隔（纳秒），0表示不限速
+        int64_t tolerance_; // 突发量对应的时间（纳秒）
+    };
+
+    Slot &SlotOf(uint32_t ip)
+    {
+        return slots_[(uint32_t)(ip * 2654435761u) >> shift_];
+    }
+
+    AdmissionOpts opts_;
+    int shift_;                      // 哈希值右移位数
+    std::unique_ptr<Slot[]> slots_;  // 计数表
+    Bucket conn_bucket_;             // 新建连接速率
+    Bucket req_bucket_;              // 请求速率
+    struct {
+        std::atomic<uint64_t> admitted{0};
+        std::atomic<uint64_t> rejected_conns{0};
+        std::atomic<uint64_t> rejected_rate{0};
+        std::atomic<uint64_t> rejected_requests{0};
+    } stats_;                        // 统计，字段含义见AdmissionStats
+};
+
+#endif
@@ -0,0 +1,136 @@
+#ifndef _ARENA_HPP_
+#define _ARENA_HPP_ 1
+
+#include <memory_resource>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+#include "nocopy.hpp"
+
+inline const size_t default_arena_block = 64 * 1024; // 竞技场每块大小（字节）
+
+/**
+ * @brief 事件循环级的单调分配器
+ * @note 分配只移动指针，释放为空操作，Reset时整体回卷。
+ *       与std::pmr::monotonic_buffer_resource不同，Reset保留已申请的普通块，
+ *       稳态下不再向上游申请内存；超过块大小的单次分配独占一块，Reset时归还。
+ *       非线程安全，只能在所属EventLoop线程中使用
+ */
+class LoopArena : public std::pmr::memory_resource, public nocopy
+{
+public:
+    explicit LoopArena(size_t block_size = default_arena_block)
+        : block_size_(block_size),
+          current_(0),
+          ptr_(nullptr),
+          end_(nullptr),
+          upstream_allocs_(0),
+          resets_(0)
+    {
+    }
+
+    ~LoopArena()
+    {
+        for (auto &block : blocks_)
+            ::operator delete(block);
+        ReleaseLarge();
+    }
+
+    // 回卷到第一块，之前分配的内存全部失效
+    void Reset()
+    {
+        ReleaseLarge();
+        current_ = 0;
+        if (blocks_.empty())
+            ptr_ = end_ = nullptr;
+        else
+        {
+            ptr_ = static_cast<char *>(blocks_[0]);
+            end_ = ptr_ + block_size_;
+        }
+        ++resets_;
+    }
+
+    /// 已持有的普通块数量
+    size_t Blocks() const { return blocks_.size(); }
+
+    /// 向上游（全局分配器）申请内存的次数
+    uint64_t UpstreamAllocs() const { return upstream_allocs_; }
+
+    /// 回卷次数
+    uint64_t Resets() const { return resets_; }
+
+private:
+    void *do_allocate(size_t bytes, size_t align) override
+    {
+        if (bytes + align > block_size_)
+        {
+            // 大对象单独分配
+            ++upstream_allocs_;
+            void *p = ::operator new(bytes, std::align_val_t(align));
+            large_.push_back({p, align});
+            return p;
+        }
+        while (true)
+        {
+            char *p = Align(ptr_, align);
+            if (p && p + bytes <= end_)
+            {
+                ptr_ = p + bytes;
+                return p;
+            }
+            NextBlock();
+        }
+    }
+
+    void do_deallocate(void *, size_t, size_t) override {} // 回卷时统一释放
+
+    bool do_is_equal(const std::pmr::memory_resource &other) const noexcept override
+    {
+        return this == &other;
+    }
+
+    static char *Align(char *p, size_t align)
+    {
+        if (!p) return nullptr;
+        uintptr_t v = reinterpret_cast<uintptr_t>(p);
+        return reinterpret_cast<char *>((v + align - 1) & ~(uintptr_t)(align - 1));
+    }
+
+    // 切换到下一块，没有则向上游申请
+    void NextBlock()
+    {
+        if (ptr_) ++current_;
+        if (current_ == blocks_.size())
+        {
+            ++upstream_allocs_;
+            blocks_.push_back(::operator new(block_size_));
+        }
+        ptr_ = static_cast<char *>(blocks_[current_]);
+        end_ = ptr_ + block_size_;
+    }
+
+    void ReleaseLarge()
+    {
+        for (auto &large : large_)
+            ::operator delete(large.ptr, std::align_val_t(large.align));
+        large_.clear();
+    }
+
+    struct Large
+    {
+        void *ptr;
+        size_t align;
+    };
+
+    size_t block_size_;          // 普通块大小
+    std::vector<void *> blocks_; // 普通块，Reset后复用
+    std::vector<Large> large_;   // 大对象，Reset时归还
+    size_t current_;             // 当前使用的块下标
+    char *ptr_;                  // 当前块内的分配位置
+    char *end_;                  // 当前块末尾
+    uint64_t upstream_allocs_;   // 上游分配次数
+    uint64_t resets_;            // 回卷次数
+};
+
+#endif
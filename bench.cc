@@ -0,0 +1,2032 @@
+#include <iostream>
+#include <string>
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <algorithm>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <pthread.h>
+#include "log.hpp"
+#include "protocol.hpp"
+#include "server_cal.hpp"
+#include "ring_queue.hpp"
+#include "timer_manager.hpp"
+#include "timer_queue.hpp"
+#include "event_loop.hpp"
+#include "coroutine.hpp"
+#include "listener.hpp"
+#include "calc_client.hpp"
+#include "admission.hpp"
+#include "static_event_loop.hpp"
+#include "leader_follower.hpp"
+#include "trace.hpp"
+#include "shm_ring.hpp"
+
+/**
+ * 热点路径微基准测试
+ * 用法: ./bench.o [-q] [-f 过滤串] [-o 输出文件] [-n 空闲连接规模]
+ *   -q  快速模式（缩小规模，适合CI冒烟）
+ *   -f  只运行名称包含该子串的用例
+ *   -o  JSON结果写入文件（默认标准输出）
+ *   -n  idle用例的连接数列表，逗号分隔（默认10万与100万）
+ * 结果以JSON输出，便于与基线逐项对比
+ */
+
+using bench_clock = std::chrono::steady_clock;
+
+// ---------------- 分配计数 ----------------
+// 替换全局operator new，统计所有线程经全局分配器的分配次数
+static std::atomic<uint64_t> alloc_count(0);
+
+void *operator new(size_t size)
+{
+    alloc_count.fetch_add(1, std::memory_order_relaxed);
+    if (void *p = malloc(size ? size : 1)) return p;
+    throw std::bad_alloc();
+}
+
+void *operator new(size_t size, std::align_val_t align)
+{
+    alloc_count.fetch_add(1, std::memory_order_relaxed);
+    size_t a = (size_t)align;
+    if (void *p = aligned_alloc(a, (size + a - 1) / a * a)) return p;
+    throw std::bad_alloc();
+}
+
+void *operator new[](size_t size) { return operator new(size); }
+void *operator new[](size_t size, std::align_val_t align) { return operator new(size, align); }
+void operator delete(void *p) noexcept { free(p); }
+void operator delete(void *p, size_t) noexcept { free(p); }
+void operator delete(void *p, std::align_val_t) noexcept { free(p); }
+void operator delete(void *p, size_t, std::align_val_t) noexcept { free(p); }
+void operator delete[](void *p) noexcept { free(p); }
+void operator delete[](void *p, size_t) noexcept { free(p); }
+void operator delete[](void *p, std::align_val_t) noexcept { free(p); }
+void operator delete[](void *p, size_t, std::align_val_t) noexcept { free(p); }
+
+static uint64_t AllocCount() { return alloc_count.load(std::memory_order_relaxed); }
+
+// 阻止编译器把被测结果优化掉
+template <class T>
+inline void DoNotOptimize(T const &value)
+{
+    asm volatile("" : : "r,m"(value) : "memory");
+}
+
+// 单条基准结果
+struct BenchResult
+{
+    std::string name;                                  // 用例名
+    std::vector<std::pair<std::string, double>> params; // 参数（线程数、规模等）
+    uint64_t ops;                                      // 完成的操作数
+    double seconds;                                    // 耗时（秒）
+    std::vector<std::pair<std::string, double>> extra; // 附加指标
+};
+
+class BenchReport
+{
+public:
+    void Add(BenchResult r)
+    {
+        // 同时在stderr打印一行便于人工查看
+        fprintf(stderr, "%-40s %12.1f ns/op %14.0f ops/s\n", r.name.c_str(),
+                r.ops ? r.seconds * 1e9 / r.ops : 0.0, r.seconds > 0 ? r.ops / r.seconds : 0.0);
+        results_.push_back(std::move(r));
+    }
+
+    std::string ToJson() const
+    {
+        std::string out = "{\n  \"benchmark\": \"reactor\",\n  \"timestamp\": ";
+        out += std::to_string(std::time(nullptr));
+        out += ",\n  \"results\": [";
+        for (size_t i = 0; i < results_.size(); ++i)
+        {
+            const BenchResult &r = results_[i];
+            out += i ? ",\n    {" : "\n    {";
+            out += "\"name\": \"" + r.name + "\", \"params\": " + Object(r.params);
+            out += ", \"ops\": " + std::to_string(r.ops);
+            out += ", \"seconds\": " + Number(r.seconds);
+            out += ", \"ns_per_op\": " + Number(r.ops ? r.seconds * 1e9 / r.ops : 0.0);
+            out += ", \"ops_per_sec\": " + Number(r.seconds > 0 ? r.ops / r.seconds : 0.0);
+            if (!r.extra.empty())
+                out += ", \"extra\": " + Object(r.extra);
+            out += "}";
+        }
+        out += "\n  ]\n}\n";
+        return out;
+    }
+
+private:
+    static std::string Number(double v)
+    {
+        char buf[64];
+        snprintf(buf, sizeof(buf), "%.6g", v);
+        return buf;
+    }
+    static std::string Object(const std::vector<std::pair<std::string, double>> &kv)
+    {
+        std::string out = "{";
+        for (size_t i = 0; i < kv.size(); ++i)
+        {
+            if (i) out += ", ";
+            out += "\"" + kv[i].first + "\": " + Number(kv[i].second);
+        }
+        return out + "}";
+    }
+
+    std::vector<BenchResult> results_;
+};
+
+static double SecondsSince(bench_clock::time_point start)
+{
+    return std::chrono::duration<double>(bench_clock::now() - start).count();
+}
+
+// 构造含n个请求帧的流水线数据包
+// wide为true时使用大负数操作数，请求与响应超出std::string的短字符串优化长度
+static std::string MakePipeline(size_t n, bool wide = false)
+{
+    std::string package;
+    for (size_t i = 0; i < n; ++i)
+    {
+        int x = wide ? -1000000000 - (int)i : (int)i;
+        int y = wide ? -(int)(i % 7) - 1 : (int)(i % 7) + 1;
+        Request req(x, y, "+-*/%"[i % 5]);
+        std::string content = req.Serialize();
+        package += Encode(content);
+    }
+    return package;
+}
+
+// ---------------- 协议编解码 ----------------
+static void BenchProtocol(BenchReport &report, bool quick)
+{
+    const size_t frames = 1000;
+    const size_t rounds = quick ? 20 : 500;
+    const std::string pipeline = MakePipeline(frames);
+
+    {
+        std::string content;
+        auto start = bench_clock::now();
+        for (size_t r = 0; r < rounds; ++r)
+        {
+            std::string package = pipeline;
+            while (Decode(package, content))
+                DoNotOptimize(content);
+        }
+        report.Add({"protocol.decode", {{"frames", (double)frames}}, frames * rounds, SecondsSince(start), {}});
+    }
+    {
+        std::string content;
+        FrameIndex index;
+        auto start = bench_clock::now();
+        for (size_t r = 0; r < rounds; ++r)
+        {
+            std::string package = pipeline;
+            while (index.Next(package, content))
+                DoNotOptimize(content);
+            index.Compact(package);
+        }
+        report.Add({"protocol.frame_index", {{"frames", (double)frames}}, frames * rounds, SecondsSince(start), {}});
+    }
+    for (size_t chunk : {64, 1460})
+    {
+        // 数据按chunk字节分段到达，每段到达后取出所有完整帧
+        std::string content, package;
+        auto start = bench_clock::now();
+        for (size_t r = 0; r < rounds; ++r)
+            for (size_t pos = 0; pos < pipeline.size(); pos += chunk)
+            {
+                package.append(pipeline, pos, chunk);
+                while (Decode(package, content))
+                    DoNotOptimize(content);
+            }
+        report.Add({"protocol.decode_chunked", {{"chunk", (double)chunk}}, frames * rounds, SecondsSince(start), {}});
+
+        FrameIndex index;
+        package.clear();
+        start = bench_clock::now();
+        for (size_t r = 0; r < rounds; ++r)
+            for (size_t pos = 0; pos < pipeline.size(); pos += chunk)
+            {
+                package.append(pipeline, pos, chunk);
+                while (index.Next(package, content))
+                    DoNotOptimize(content);
+                index.Compact(package);
+            }
+        report.Add({"protocol.frame_index_chunked", {{"chunk", (double)chunk}}, frames * rounds, SecondsSince(start), {}});
+    }
+    {
+        // 分隔符扫描吞吐：1MB流水线数据
+        std::string data;
+        while (data.size() < (1 << 20)) data += pipeline;
+        struct Scanner
+        {
+            const char *name;
+            sep_scanner_t scan;
+        } scanners[] = {
+            {"protocol.scan_scalar", ScanSepScalar},
+#if defined(__x86_64__) || defined(__i386__)
+            {"protocol.scan_sse2", ScanSepSse2},
+            {"protocol.scan_avx2", __builtin_cpu_supports("avx2") ? ScanSepAvx2 : nullptr},
+#endif
+        };
+        const size_t reps = quick ? 20 : 500;
+        std::vector<size_t> seps;
+        for (auto &scanner : scanners)
+        {
+            if (!scanner.scan) continue;
+            auto start = bench_clock::now();
+            for (size_t r = 0; r < reps; ++r)
+            {
+                seps.clear();
+                scanner.scan(data.data(), 0, data.size(), seps);
+                DoNotOptimize(seps);
+            }
+            double seconds = SecondsSince(start);
+            report.Add({scanner.name, {{"bytes", (double)data.size()}}, reps, seconds,
+                        {{"gb_per_s", data.size() * reps / seconds / 1e9}, {"separators", (double)seps.size()}}});
+        }
+    }
+    {
+        std::string content = "12345 6789";
+        const size_t n = frames * rounds;
+        auto start = bench_clock::now();
+        for (size_t i = 0; i < n; ++i)
+        {
+            std::string out = Encode(content);
+            DoNotOptimize(out);
+        }
+        report.Add({"protocol.encode", {}, n, SecondsSince(start), {}});
+    }
+    const size_t n = frames * rounds;
+    {
+        Request req(12345, 678, '*');
+        auto start = bench_clock::now();
+        for (size_t i = 0; i < n; ++i)
+        {
+            std::string out = req.Serialize();
+            DoNotOptimize(out);
+        }
+        report.Add({"request.serialize", {}, n, SecondsSince(start), {}});
+    }
+    {
+        std::string in = "12345 * 678";
+        Request req;
+        auto start = bench_clock::now();
+        for (size_t i = 0; i < n; ++i)
+        {
+            req.Deserialize(in);
+            DoNotOptimize(req);
+        }
+        report.Add({"request.deserialize", {}, n, SecondsSince(start), {}});
+    }
+    {
+        Response resp(8393910, 0);
+        auto start = bench_clock::now();
+        for (size_t i = 0; i < n; ++i)
+        {
+            std::string out = resp.Serialize();
+            DoNotOptimize(out);
+        }
+        report.Add({"response.serialize", {}, n, SecondsSince(start), {}});
+    }
+    {
+        // 序列化+编码+追加到输出缓冲区：旧路径与原地序列化对比
+        Response resp(8393910, 0);
+        std::string out;
+        auto start = bench_clock::now();
+        for (size_t i = 0; i < n; ++i)
+        {
+            if ((i & 1023) == 0) out.clear();
+            std::string content = resp.Serialize();
+            out += Encode(content);
+        }
+        DoNotOptimize(out);
+        report.Add({"response.serialize_encode_append", {}, n, SecondsSince(start), {}});
+
+        out.clear();
+        start = bench_clock::now();
+        for (size_t i = 0; i < n; ++i)
+        {
+            if ((i & 1023) == 0) out.clear();
+            resp.SerializeTo(out);
+        }
+        DoNotOptimize(out);
+        report.Add({"response.serialize_to", {}, n, SecondsSince(start), {}});
+
+        Request req(12345, 678, '*');
+        out.clear();
+        start = bench_clock::now();
+        for (size_t i = 0; i < n; ++i)
+        {
+            if ((i & 1023) == 0) out.clear();
+            req.SerializeTo(out);
+        }
+        DoNotOptimize(out);
+        report.Add({"request.serialize_to", {}, n, SecondsSince(start), {}});
+    }
+    {
+        std::string in = "8393910 0";
+        Response resp;
+        auto start = bench_clock::now();
+        for (size_t i = 0; i < n; ++i)
+        {
+            resp.Deserialize(in);
+            DoNotOptimize(resp);
+        }
+        report.Add({"response.deserialize", {}, n, SecondsSince(start), {}});
+    }
+    {
+        ServerCal sc;
+        auto start = bench_clock::now();
+        for (size_t r = 0; r < rounds; ++r)
+        {
+            std::string package = pipeline;
+            while (true)
+            {
+                std::string out = sc.Calculator(package);
+                if (out.empty()) break;
+                DoNotOptimize(out);
+            }
+        }
+        report.Add({"server_cal.calculator", {{"frames", (double)frames}}, frames * rounds, SecondsSince(start), {}});
+    }
+    for (bool wide : {false, true})
+    {
+        // 逐帧计算：全局分配器与竞技场（每64帧回卷一次，模拟一轮分发）对比
+        const std::string batch = MakePipeline(64, wide);
+        const size_t batches = frames * rounds / 64;
+        ServerCal sc;
+        uint64_t allocs = AllocCount();
+        auto start = bench_clock::now();
+        for (size_t r = 0; r < batches; ++r)
+        {
+            std::string package = batch;
+            while (true)
+            {
+                std::string out = sc.Calculator(package);
+                if (out.empty()) break;
+                DoNotOptimize(out);
+            }
+        }
+        double seconds = SecondsSince(start);
+        report.Add({"server_cal.calculator_global", {{"wide", (double)wide}}, batches * 64, seconds,
+                    {{"allocs_per_op", (double)(AllocCount() - allocs) / (batches * 64)}}});
+
+        LoopArena arena;
+        allocs = AllocCount();
+        start = bench_clock::now();
+        for (size_t r = 0; r < batches; ++r)
+        {
+            std::string package = batch;
+            arena.Reset();
+            while (true)
+            {
+                std::pmr::string out = sc.Calculator(package, &arena);
+                if (out.empty()) break;
+                DoNotOptimize(out);
+            }
+        }
+        seconds = SecondsSince(start);
+        report.Add({"server_cal.calculator_arena", {{"wide", (double)wide}}, batches * 64, seconds,
+                    {{"allocs_per_op", (double)(AllocCount() - allocs) / (batches * 64)},
+                     {"arena_blocks", (double)arena.Blocks()}}});
+    }
+    for (size_t depth : {1, 16, 1000})
+    {
+        // 同样的请求总数，按流水线深度分批
+        ServerCal sc;
+        const std::string batch = MakePipeline(depth);
+        const size_t batches = frames * rounds / depth;
+        std::string out;
+        auto start = bench_clock::now();
+        for (size_t r = 0; r < batches; ++r)
+        {
+            std::string package = batch;
+            out.clear();
+            sc.CalculatorBatch(package, out);
+            DoNotOptimize(out);
+        }
+        report.Add({"server_cal.calculator_batch", {{"frames", (double)depth}}, batches * depth, SecondsSince(start),
+                    {{"kernel_avx2", strcmp(ServerCal::KernelName(), "avx2") == 0 ? 1.0 : 0.0}}});
+    }
+    {
+        // 仅求值内核：列式数据已就绪
+        const size_t count = 4096;
+        std::vector<int32_t> x(count), y(count), op(count), res(count), code(count);
+        uint32_t seed = 12345;
+        for (size_t i = 0; i < count; ++i)
+        {
+            seed = seed * 1103515245 + 12345;
+            x[i] = (int32_t)seed;
+            y[i] = (int32_t)(seed >> 16) % 100;
+            op[i] = "+-*/%"[(seed >> 8) % 5];
+        }
+        struct Kernel
+        {
+            const char *name;
+            cal_kernel_t eval;
+        } kernels[] = {
+            {"calculator.kernel_scalar", ServerCal::EvalScalar},
+#if defined(__x86_64__) || defined(__i386__)
+            {"calculator.kernel_avx2", __builtin_cpu_supports("avx2") ? ServerCal::EvalAvx2 : nullptr},
+#endif
+        };
+        const size_t reps = quick ? 200 : 5000;
+        for (auto &kernel : kernels)
+        {
+            if (!kernel.eval) continue;
+            auto start = bench_clock::now();
+            for (size_t r = 0; r < reps; ++r)
+            {
+                kernel.eval(x.data(), y.data(), op.data(), res.data(), code.data(), count);
+                DoNotOptimize(res);
+            }
+            report.Add({kernel.name, {{"requests", (double)count}}, count * reps, SecondsSince(start), {}});
+        }
+    }
+}
+
+// ---------------- 环形队列 ----------------
+static void BenchRingQueue(BenchReport &report, bool quick)
+{
+    const size_t per_producer = quick ? 20000 : 500000;
+    const int counts[] = {1, 2, 4};
+    for (int producers : counts)
+    {
+        for (int consumers : counts)
+        {
+            RingQueue<ClientInf> rq(1024);
+            std::atomic<int> producing(producers);
+            std::atomic<uint64_t> popped(0);
+            std::vector<std::thread> threads;
+
+            auto start = bench_clock::now();
+            for (int p = 0; p < producers; ++p)
+            {
+                threads.emplace_back([&rq, &producing, per_producer]() {
+                    ClientInf ci{.sockfd = 0, .client_ip = htonl(INADDR_LOOPBACK), .client_port = 0, .family = AF_INET};
+                    for (size_t i = 0; i < per_producer; ++i)
+                    {
+                        ci.sockfd = (int)i;
+                        rq.Push(ci); // 队列满时Push返回false，此处直接丢弃
+                    }
+                    --producing;
+                });
+            }
+            for (int c = 0; c < consumers; ++c)
+            {
+                threads.emplace_back([&rq, &producing, &popped]() {
+                    uint64_t local = 0;
+                    while (true)
+                    {
+                        if (auto ci = rq.Pop())
+                        {
+                            DoNotOptimize(ci->sockfd);
+                            ++local;
+                        }
+                        else if (producing.load() == 0)
+                        {
+                            // 生产者结束后再确认一次队列已空
+                            if (!rq.Pop()) break;
+                            ++local;
+                        }
+                    }
+                    popped += local;
+                });
+            }
+            for (auto &t : threads) t.join();
+            double seconds = SecondsSince(start);
+
+            uint64_t pushed = per_producer * producers;
+            report.Add({"ring_queue.push_pop",
+                        {{"producers", (double)producers}, {"consumers", (double)consumers}},
+                        popped.load(), seconds,
+                        {{"attempted", (double)pushed}, {"dropped", (double)(pushed - popped.load())},
+                         {"queue_full", (double)rq.FullCount()}}});
+        }
+    }
+}
+
+// ---------------- 定时器管理 ----------------
+static void BenchTimerManager(BenchReport &report, bool quick)
+{
+    std::vector<size_t> sizes = {10000, 100000};
+    if (!quick) sizes.push_back(1000000);
+
+    for (size_t n : sizes)
+    {
+        std::vector<std::shared_ptr<Connection>> conns;
+        conns.reserve(n);
+        for (size_t i = 0; i < n; ++i)
+            conns.emplace_back(new Connection((int)i));
+
+        TimerManager tm;
+        auto start = bench_clock::now();
+        for (auto &conn : conns)
+            tm.Push(conn);
+        report.Add({"timer_manager.push", {{"connections", (double)n}}, n, SecondsSince(start), {}});
+
+        uint64_t seed = 42; // 简单LCG，避免<random>引入的::log与日志类重名
+        start = bench_clock::now();
+        for (size_t i = 0; i < n; ++i)
+        {
+            seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+            tm.UpdateTime((int)((seed >> 33) % n));
+        }
+        report.Add({"timer_manager.update_time", {{"connections", (double)n}}, n, SecondsSince(start), {}});
+
+        start = bench_clock::now();
+        for (size_t i = 0; i < n; ++i)
+            DoNotOptimize(tm.IsTopExpired());
+        report.Add({"timer_manager.is_top_expired", {{"connections", (double)n}}, n, SecondsSince(start), {}});
+    }
+}
+
+// ---------------- 通用定时器 ----------------
+static void BenchTimerQueue(BenchReport &report, bool quick)
+{
+    std::vector<size_t> sizes = {10000, 100000};
+    if (!quick) sizes.push_back(1000000);
+
+    for (size_t n : sizes)
+    {
+        TimerQueue tq;
+        std::vector<timer_id_t> ids;
+        ids.reserve(n);
+        size_t fired = 0;
+        uint64_t seed = 42;
+        auto start = bench_clock::now();
+        for (size_t i = 0; i < n; ++i)
+        {
+            seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+            ids.push_back(tq.Add((int64_t)((seed >> 33) % 60000), 0, [&fired]() { ++fired; }));
+        }
+        report.Add({"timer_queue.add", {{"timers", (double)n}}, n, SecondsSince(start), {}});
+
+        // 取消一半，堆中失效条目超过一半时整体重建
+        start = bench_clock::now();
+        for (size_t i = 0; i < n; i += 2)
+            tq.Cancel(ids[i]);
+        report.Add({"timer_queue.cancel", {{"timers", (double)n}}, n / 2, SecondsSince(start),
+                    {{"pending", (double)tq.Size()}, {"heap", (double)tq.HeapSize()}}});
+
+        start = bench_clock::now();
+        for (int64_t now = 0; now <= 60000; now += 10)
+            tq.RunExpired(now);
+        report.Add({"timer_queue.expire", {{"timers", (double)n}}, fired, SecondsSince(start),
+                    {{"pending", (double)tq.Size()}}});
+    }
+
+    // 周期定时器：1万个，各自以1~100ms为周期推进10秒
+    const size_t periodic = 10000;
+    TimerQueue tq;
+    size_t ticks = 0;
+    for (size_t i = 0; i < periodic; ++i)
+        tq.Add(0, 1 + (int64_t)(i % 100), [&ticks]() { ++ticks; });
+    auto start = bench_clock::now();
+    for (int64_t now = 0; now < (quick ? 1000 : 10000); ++now)
+        tq.RunExpired(now);
+    report.Add({"timer_queue.periodic", {{"timers", (double)periodic}}, ticks, SecondsSince(start),
+                {{"heap", (double)tq.HeapSize()}}});
+}
+
+// ---------------- 连接缓冲区 ----------------
+static void BenchConnectionBuffer(BenchReport &report, bool quick)
+{
+    const size_t n = quick ? 100000 : 5000000;
+    const std::string chunk(64, 'x');
+    {
+        Connection conn(0);
+        auto start = bench_clock::now();
+        for (size_t i = 0; i < n; ++i)
+        {
+            conn.AppendOutBuffer(chunk);
+            if (conn.OutBuffer().size() >= 64 * 1024) conn.OutBuffer().clear();
+        }
+        report.Add({"connection.append", {{"chunk", 64}}, n, SecondsSince(start), {}});
+    }
+    {
+        // 模拟Send部分发送：追加后从头部擦除
+        Connection conn(0);
+        conn.AppendOutBuffer(std::string(4096, 'x'));
+        auto start = bench_clock::now();
+        for (size_t i = 0; i < n; ++i)
+        {
+            conn.AppendOutBuffer(chunk);
+            conn.OutBuffer().erase(0, chunk.size());
+        }
+        report.Add({"connection.erase_front", {{"chunk", 64}, {"resident", 4096}}, n, SecondsSince(start), {}});
+    }
+}
+
+// ---------------- 事件分发 ----------------
+static ServerCal bench_sc;
+
+// 与main.cc中MessageHandler一致的计算器回显
+static void BenchMessageHandler(std::weak_ptr<Connection> wconn)
+{
+    auto connection = wconn.lock();
+    buffer_t &inf = connection->Inbuffer();
+    while (true)
+    {
+        std::string outinf = bench_sc.Calculator(inf);
+        if (outinf.empty()) return;
+        connection->AppendOutBuffer(outinf);
+        connection->el.lock()->Send(connection);
+    }
+}
+
+// 协程版本的计算器回显
+// 与BenchMessageHandler相同，临时对象分配在事件循环竞技场上
+static void BenchArenaHandler(std::weak_ptr<Connection> wconn)
+{
+    auto connection = wconn.lock();
+    buffer_t &inf = connection->Inbuffer();
+    while (true)
+    {
+        std::pmr::string outinf = bench_sc.Calculator(inf, EventLoop::CurrentArena());
+        if (outinf.empty()) return;
+        connection->AppendOutBuffer(outinf);
+        connection->el.lock()->Send(connection);
+    }
+}
+
+static CoTask BenchCoHandler(std::shared_ptr<Connection> connection)
+{
+    while (auto frame = co_await connection->ReadFrame())
+    {
+        Request req;
+        if (!req.Deserialize(*frame)) co_return;
+        std::string content = bench_sc.CalculatorHelper(req).Serialize();
+        if (!co_await connection->Write(Encode(content))) co_return;
+    }
+}
+
+// 读取阻塞socket直到收满expected个响应帧
+static bool ReadResponses(int fd, std::string &pending, size_t expected)
+{
+    char buf[4096];
+    std::string content;
+    size_t got = 0;
+    while (got < expected)
+    {
+        while (got < expected && Decode(pending, content)) ++got;
+        if (got == expected) break;
+        ssize_t n = recv(fd, buf, sizeof(buf), 0);
+        if (n <= 0) return false;
+        pending.append(buf, n);
+    }
+    return true;
+}
+
+static void BenchDispatcher(BenchReport &report, bool quick)
+{
+    const size_t rounds = quick ? 2000 : 100000;
+    struct Mode
+    {
+        const char *name;
+        func_t handler;
+    } modes[] = {
+        {"event_loop.dispatch", BenchMessageHandler},
+        {"event_loop.dispatch_arena", BenchArenaHandler},
+        {"event_loop.dispatch_coroutine", CoMessageHandler(BenchCoHandler)},
+    };
+    for (auto &mode : modes)
+    for (size_t depth : {1, 16, 64})
+    for (bool wide : {false, true})
+    {
+        int sv[2];
+        if (socketpair(AF_UNIX, SOCK_STREAM, 0, sv) == -1)
+        {
+            perror("socketpair");
+            return;
+        }
+        SetNonBlockOrDie(sv[0]);
+
+        std::shared_ptr<EventLoop> el(new EventLoop(nullptr, mode.handler));
+        el->AddConnection(sv[0], EPOLLIN | EPOLLET,
+                          std::bind(&EventLoop::Recv, el, std::placeholders::_1),
+                          std::bind(&EventLoop::Send, el, std::placeholders::_1),
+                          std::bind(&EventLoop::Except, el, std::placeholders::_1));
+
+        const std::string batch = MakePipeline(depth, wide);
+        std::string pending;
+        bool ok = true;
+        uint64_t allocs = AllocCount();
+        auto start = bench_clock::now();
+        for (size_t r = 0; r < rounds && ok; ++r)
+        {
+            send(sv[1], batch.data(), batch.size(), 0);
+            el->DisPatcher();
+            ok = ReadResponses(sv[1], pending, depth);
+        }
+        double seconds = SecondsSince(start);
+        // 分配计数包含客户端侧ReadResponses的解码
+        report.Add({mode.name, {{"pipeline_depth", (double)depth}, {"wide", (double)wide}}, rounds * depth, seconds,
+                    {{"round_trips", (double)rounds},
+                     {"allocs_per_op", (double)(AllocCount() - allocs) / (rounds * depth)}}});
+
+        close(sv[1]);
+        el->DisPatcher(); // 触发对端关闭处理，回收sv[0]
+    }
+}
+
+// ---------------- 编译期特化的事件循环 ----------------
+// 与CalcCodec + CalcHandler逐请求处理相同的工作，经std::function与weak_ptr分发
+static void BenchPerRequestHandler(std::weak_ptr<Connection> wconn)
+{
+    auto connection = wconn.lock();
+    buffer_t &inf = connection->Inbuffer();
+    FrameIndex &frames = connection->Frames();
+    static thread_local std::string content;
+    Request req;
+    size_t n = 0;
+    while (frames.Next(inf, content))
+    {
+        if (!req.Deserialize(content)) continue;
+        bench_sc.CalculatorHelper(req).SerializeTo(connection->OutTail());
+        ++n;
+    }
+    frames.Compact(inf);
+    if (n) connection->el.lock()->Send(connection);
+}
+
+static void BenchStaticLoop(BenchReport &report, bool quick)
+{
+    const size_t rounds = quick ? 2000 : 100000;
+    for (size_t depth : {1, 16, 64})
+    for (bool is_static : {false, true})
+    {
+        int sv[2];
+        if (socketpair(AF_UNIX, SOCK_STREAM, 0, sv) == -1)
+        {
+            perror("socketpair");
+            return;
+        }
+        SetNonBlockOrDie(sv[0]);
+
+        std::shared_ptr<EventLoop> el;
+        std::unique_ptr<StaticEventLoop<CalcHandler, CalcCodec>> sl;
+        if (is_static)
+        {
+            sl.reset(new StaticEventLoop<CalcHandler, CalcCodec>());
+            sl->AddConnection(sv[0], INADDR_ANY, 0, AF_UNIX);
+        }
+        else
+        {
+            el.reset(new EventLoop(nullptr, BenchPerRequestHandler));
+            el->AddConnection(sv[0], EPOLLIN | EPOLLET,
+                              std::bind(&EventLoop::Recv, el, std::placeholders::_1),
+                              std::bind(&EventLoop::Send, el, std::placeholders::_1),
+                              std::bind(&EventLoop::Except, el, std::placeholders::_1));
+        }
+
+        const std::string batch = MakePipeline(depth);
+        std::string pending;
+        bool ok = true;
+        uint64_t allocs = AllocCount();
+        auto start = bench_clock::now();
+        for (size_t r = 0; r < rounds && ok; ++r)
+        {
+            send(sv[1], batch.data(), batch.size(), 0);
+            if (is_static) sl->DisPatcher();
+            else el->DisPatcher();
+            ok = ReadResponses(sv[1], pending, depth);
+        }
+        double seconds = SecondsSince(start);
+        report.Add({is_static ? "static_loop.static" : "static_loop.type_erased", {{"pipeline_depth", (double)depth}},
+                    rounds * depth, seconds,
+                    {{"round_trips", (double)rounds},
+                     {"allocs_per_op", (double)(AllocCount() - allocs) / (rounds * depth)},
+                     {"ok", (double)ok}}});
+
+        close(sv[1]);
+        if (is_static) sl->DisPatcher(); // 触发对端关闭处理，回收sv[0]
+        else el->DisPatcher();
+    }
+}
+
+// ---------------- 事件跟踪 ----------------
+static void BenchTrace(BenchReport &report, bool quick)
+{
+    const size_t n = quick ? 200000 : 5000000;
+    for (bool enabled : {false, true})
+    {
+        if (enabled) Tracer::Instance().Enable();
+        auto start = bench_clock::now();
+        for (size_t i = 0; i < n; ++i)
+        {
+            TraceScope trace("bench", "i", (int64_t)i);
+            DoNotOptimize(i);
+        }
+        report.Add({enabled ? "trace.scope_enabled" : "trace.scope_disabled", {}, n, SecondsSince(start), {}});
+    }
+
+    std::string path = "/tmp/bench_trace_" + std::to_string(getpid()) + ".json";
+    auto start = bench_clock::now();
+    long events = Tracer::Instance().Dump(path);
+    report.Add({"trace.dump", {{"ring_events", (double)default_trace_events}}, (uint64_t)(events > 0 ? events : 0),
+                SecondsSince(start), {}});
+    unlink(path.c_str());
+    Tracer::Instance().Disable();
+}
+
+// ---------------- 连接迁移 ----------------
+// 单线程在两个事件循环之间来回迁移一个连接：摘除、缓冲区换池、排队、接管
+// 输入缓冲区预置buffered字节的半帧，衡量随连接转移的缓冲数据量的影响
+static void BenchMigrate(BenchReport &report, bool quick)
+{
+    const size_t rounds = quick ? 20000 : 500000;
+    for (size_t buffered : {0, 4096, 65536})
+    {
+        int sv[2];
+        if (socketpair(AF_UNIX, SOCK_STREAM, 0, sv) == -1)
+        {
+            perror("socketpair");
+            return;
+        }
+        SetNonBlockOrDie(sv[0]);
+        std::shared_ptr<EventLoop> loops[2] = {std::shared_ptr<EventLoop>(new EventLoop(nullptr, BenchMessageHandler)),
+                                               std::shared_ptr<EventLoop>(new EventLoop(nullptr, BenchMessageHandler))};
+        auto connection = loops[0]->AddConnection(sv[0], EPOLLIN | EPOLLET,
+                                                  std::bind(&EventLoop::Recv, loops[0], std::placeholders::_1),
+                                                  std::bind(&EventLoop::Send, loops[0], std::placeholders::_1),
+                                                  std::bind(&EventLoop::Except, loops[0], std::placeholders::_1));
+        // 长度字段声明的内容比预置数据长，始终是未收全的半帧
+        std::string partial = std::to_string(buffered + 1) + "\n" + std::string(buffered, 'x');
+        if (buffered) connection->AppendInBuffer(partial);
+        connection.reset();
+
+        bool ok = true;
+        auto start = bench_clock::now();
+        for (size_t r = 0; r < rounds && ok; ++r)
+        {
+            auto &from = loops[r % 2], &to = loops[(r + 1) % 2];
+            ok = from->MigrateConnection(sv[0], to);
+            to->RunPending();
+        }
+        double seconds = SecondsSince(start);
+        report.Add({"migrate.connection", {{"buffered_bytes", (double)buffered}}, rounds, seconds,
+                    {{"ok", (double)ok}}});
+
+        // 迁移后连接仍能正常处理请求
+        auto &owner = loops[rounds % 2];
+        if (!buffered)
+        {
+            std::string batch = MakePipeline(1);
+            std::string pending;
+            send(sv[1], batch.data(), batch.size(), 0);
+            owner->DisPatcher();
+            if (!ReadResponses(sv[1], pending, 1)) fprintf(stderr, "migrate: no response after migration\n");
+        }
+        close(sv[1]);
+        owner->DisPatcher();
+    }
+}
+
+// ---------------- 传输层对比 ----------------
+// 与main.cc中TaskPush一致
+static void BenchTaskPush(std::weak_ptr<RingQueue<ClientInf>> wrq, std::weak_ptr<EventLoop> wel)
+{
+    auto rq = wrq.lock();
+    auto el = wel.lock();
+    if (auto client_inf = rq->Pop())
+    {
+        if (client_inf->shm)
+        {
+            el->AddShmConnection(client_inf->sockfd);
+            return;
+        }
+        auto connection = el->AddConnection(
+            client_inf->sockfd, EPOLLIN | EPOLLET,
+            std::bind(&EventLoop::Recv, el, std::placeholders::_1),
+            std::bind(&EventLoop::Send, el, std::placeholders::_1),
+            std::bind(&EventLoop::Except, el, std::placeholders::_1),
+            client_inf->client_ip, client_inf->client_port);
+        connection->family_ = client_inf->family;
+    }
+}
+
+// 进程内服务端：一个监听线程 + 一个工作线程
+class BenchServer
+{
+public:
+    explicit BenchServer(func_t handler, size_t queue_cap = 4096)
+        : rq_(new RingQueue<ClientInf>(queue_cap)),
+          base_(new EventLoop(rq_))
+    {
+        rq_->EnableNotify(); // 须在工作EventLoop构造前开启
+        worker_.reset(new EventLoop(rq_, handler, BenchTaskPush));
+    }
+
+    std::shared_ptr<EventLoop> Worker() { return worker_; }
+
+    std::shared_ptr<RingQueue<ClientInf>> Queue() { return rq_; }
+
+    // 工作线程累计占用的CPU时间（纳秒）
+    uint64_t WorkerCpuNs()
+    {
+        clockid_t cid;
+        struct timespec ts;
+        if (pthread_getcpuclockid(threads_[1].native_handle(), &cid) != 0) return 0;
+        clock_gettime(cid, &ts);
+        return ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+    }
+
+    void AddListener(std::shared_ptr<Listener> lt)
+    {
+        lt->Init();
+        base_->AddConnection(lt->Fd(), EPOLLIN | EPOLLET,
+                             std::bind(&Listener::Accepter, lt, std::placeholders::_1),
+                             nullptr, nullptr, INADDR_ANY, 0, true);
+    }
+
+    void Start()
+    {
+        threads_.emplace_back([loop = base_]() { loop->Loop(); });
+        threads_.emplace_back([loop = worker_]() { loop->Loop(); });
+    }
+
+    void Stop()
+    {
+        base_->Stop();
+        worker_->Stop();
+        for (auto &t : threads_) t.join();
+    }
+
+private:
+    std::shared_ptr<RingQueue<ClientInf>> rq_;
+    std::shared_ptr<EventLoop> base_;
+    std::shared_ptr<EventLoop> worker_;
+    std::vector<std::thread> threads_;
+};
+
+// 连接到TCP回环端口；host_index选择127.0.0.x，突破单目的地址的临时端口数限制
+static int ConnectTcp(uint16_t port, uint32_t host_index = 0)
+{
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (fd == -1) return -1;
+    struct sockaddr_in server;
+    bzero(&server, sizeof(server));
+    server.sin_family = AF_INET;
+    server.sin_port = htons(port);
+    server.sin_addr.s_addr = htonl(INADDR_LOOPBACK + host_index);
+    if (connect(fd, (struct sockaddr *)&server, sizeof(server)) == -1)
+    {
+        perror("connect");
+        close(fd);
+        return -1;
+    }
+    int on = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+    return fd;
+}
+
+// 连接到Unix域socket
+static int ConnectUnix(const std::string &path, int type)
+{
+    int fd = socket(AF_UNIX, type, 0);
+    struct sockaddr_un server;
+    bzero(&server, sizeof(server));
+    server.sun_family = AF_UNIX;
+    strncpy(server.sun_path, path.c_str(), sizeof(server.sun_path) - 1);
+    if (connect(fd, (struct sockaddr *)&server, sizeof(server)) == -1)
+    {
+        perror("connect");
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+// 在已连接的fd上做rounds次深度为depth的请求-响应往返
+static bool RoundTrips(int fd, size_t rounds, size_t depth)
+{
+    const std::string batch = MakePipeline(depth);
+    std::string pending;
+    for (size_t r = 0; r < rounds; ++r)
+    {
+        if (send(fd, batch.data(), batch.size(), 0) != (ssize_t)batch.size()) return false;
+        if (!ReadResponses(fd, pending, depth)) return false;
+    }
+    return true;
+}
+
+// 经共享内存通道做rounds次深度为depth的请求-响应往返
+static bool ShmRoundTrips(ShmChannel &channel, size_t rounds, size_t depth)
+{
+    const std::string batch = MakePipeline(depth);
+    std::string pending;
+    std::string content;
+    for (size_t r = 0; r < rounds; ++r)
+    {
+        size_t sent = 0;
+        size_t got = 0;
+        while (sent < batch.size() || got < depth)
+        {
+            if (sent < batch.size()) sent += channel.Send(batch.data() + sent, batch.size() - sent);
+            if (channel.Recv(pending) == 0 && !channel.Wait(1000)) return false;
+            while (got < depth && Decode(pending, content)) ++got;
+        }
+    }
+    return true;
+}
+
+static void BenchTransport(BenchReport &report, bool quick)
+{
+    const size_t rounds = quick ? 2000 : 50000;
+    const std::string unix_path = "/tmp/reactor_bench_" + std::to_string(getpid()) + ".sock";
+    const std::string seqpacket_path = unix_path + "q";
+    const std::string shm_path = unix_path + "m";
+
+    std::shared_ptr<Listener> tcp(new Listener(0));
+    BenchServer server(BenchMessageHandler);
+    server.AddListener(tcp);
+    server.AddListener(std::shared_ptr<Listener>(new Listener(unix_path, SOCK_STREAM)));
+    server.AddListener(std::shared_ptr<Listener>(new Listener(seqpacket_path, SOCK_SEQPACKET)));
+    std::shared_ptr<Listener> shm(new Listener(shm_path, SOCK_STREAM));
+    shm->EnableShm();
+    server.AddListener(shm);
+    server.Start();
+
+    struct sockaddr_in local;
+    socklen_t len = sizeof(local);
+    getsockname(tcp->Fd(), (struct sockaddr *)&local, &len);
+    uint16_t port = ntohs(local.sin_port);
+
+    struct Transport
+    {
+        const char *name;
+        std::function<int()> connect;
+    } transports[] = {
+        {"transport.tcp_loopback", [port]() { return ConnectTcp(port); }},
+        {"transport.unix_stream", [&]() { return ConnectUnix(unix_path, SOCK_STREAM); }},
+        {"transport.unix_seqpacket", [&]() { return ConnectUnix(seqpacket_path, SOCK_SEQPACKET); }},
+    };
+    for (auto &transport : transports)
+    {
+        for (size_t depth : {1, 16})
+        {
+            int fd = transport.connect();
+            if (fd < 0) continue;
+            RoundTrips(fd, 1, 1); // 预热：等待工作线程接管连接
+            auto start = bench_clock::now();
+            bool ok = RoundTrips(fd, rounds, depth);
+            double seconds = SecondsSince(start);
+            close(fd);
+            if (!ok) continue;
+            report.Add({transport.name, {{"pipeline_depth", (double)depth}}, rounds * depth, seconds,
+                        {{"round_trips", (double)rounds}, {"us_per_round_trip", seconds * 1e6 / rounds}}});
+        }
+    }
+
+    // 共享内存环：每个方向只在环由空变为非空时写一次eventfd
+    for (size_t depth : {1, 16})
+    {
+        auto channel = ShmChannel::Connect(shm_path);
+        if (!channel) break;
+        ShmRoundTrips(*channel, 1, 1); // 预热：等待工作线程完成握手
+        uint64_t notifies = channel->Notifies();
+        auto start = bench_clock::now();
+        bool ok = ShmRoundTrips(*channel, rounds, depth);
+        double seconds = SecondsSince(start);
+        notifies = channel->Notifies() - notifies;
+        channel->Close();
+        if (!ok) continue;
+        report.Add({"transport.shm_ring", {{"pipeline_depth", (double)depth}}, rounds * depth, seconds,
+                    {{"round_trips", (double)rounds}, {"us_per_round_trip", seconds * 1e6 / rounds},
+                     {"client_notifies_per_round_trip", (double)notifies / rounds}}});
+    }
+
+    server.Stop();
+    unlink(unix_path.c_str());
+    unlink(seqpacket_path.c_str());
+}
+
+// ---------------- 海量空闲连接 ----------------
+static std::vector<size_t> idle_sizes; // -n 指定的连接规模
+
+// 当前进程常驻内存（字节）
+static uint64_t RssBytes()
+{
+    long pages = 0, resident = 0;
+    FILE *fp = fopen("/proc/self/statm", "r");
+    if (!fp) return 0;
+    if (fscanf(fp, "%ld %ld", &pages, &resident) != 2) resident = 0;
+    fclose(fp);
+    return resident * sysconf(_SC_PAGESIZE);
+}
+
+struct IdleSample
+{
+    double established;      // 实际建立的空闲连接数
+    double rss_before;       // 建连前RSS
+    double rss_after;        // 建连后RSS
+    double rounds;           // 活跃连接往返次数
+    double seconds;          // 往返耗时
+    double iterations;       // 期间工作线程循环轮数
+    double cpu_ns;           // 期间工作线程CPU时间
+    double event_batch;      // 结束时epoll事件批量
+};
+
+// 在子进程中运行：建立n个空闲连接，再用一个活跃连接测量循环开销
+static IdleSample RunIdle(size_t n, size_t rounds)
+{
+    IdleSample sample = {};
+    BenchServer server(BenchMessageHandler);
+    server.Worker()->SetIdleTimeout(3600); // 测试期间空闲连接不过期
+    server.Worker()->Reserve(n + 1);
+    std::shared_ptr<Listener> tcp(new Listener(0, 65535));
+    server.AddListener(tcp);
+    server.Start();
+
+    struct sockaddr_in local;
+    socklen_t len = sizeof(local);
+    getsockname(tcp->Fd(), (struct sockaddr *)&local, &len);
+    uint16_t port = ntohs(local.sin_port);
+
+    sample.rss_before = RssBytes();
+    std::vector<int> fds;
+    fds.reserve(n);
+    const size_t chunk = 512;
+    const size_t per_host = 25000; // 每个回环目的地址使用的临时端口数
+    while (fds.size() < n)
+    {
+        size_t target = std::min(n, fds.size() + chunk);
+        while (fds.size() < target)
+        {
+            int fd = ConnectTcp(port, (uint32_t)(fds.size() / per_host));
+            if (fd < 0) break;
+            fds.push_back(fd);
+        }
+        // 最后一个连接完成往返，说明此前的连接都已被工作线程接管
+        if (fds.empty() || !RoundTrips(fds.back(), 1, 1) || fds.size() < target) break;
+    }
+    sample.established = fds.size();
+    sample.rss_after = RssBytes();
+
+    int active = ConnectTcp(port);
+    if (active >= 0 && RoundTrips(active, 1, 1))
+    {
+        uint64_t cpu0 = server.WorkerCpuNs();
+        uint64_t it0 = server.Worker()->Iterations();
+        auto start = bench_clock::now();
+        if (RoundTrips(active, rounds, 1))
+        {
+            sample.seconds = SecondsSince(start);
+            sample.rounds = rounds;
+            sample.iterations = server.Worker()->Iterations() - it0;
+            sample.cpu_ns = server.WorkerCpuNs() - cpu0;
+        }
+    }
+    sample.event_batch = server.Worker()->EventBatch();
+    server.Stop(); // 连接由子进程退出时统一回收
+    return sample;
+}
+
+static void BenchIdle(BenchReport &report, bool quick)
+{
+    std::vector<size_t> sizes = idle_sizes;
+    if (sizes.empty())
+        sizes = quick ? std::vector<size_t>{2000} : std::vector<size_t>{100000, 1000000};
+    const size_t rounds = quick ? 2000 : 20000;
+
+    for (size_t n : sizes)
+    {
+        // 每个规模在独立子进程中运行，退出时由内核回收全部连接，RSS也互不干扰
+        int pipefd[2];
+        if (pipe(pipefd) == -1) return;
+        pid_t pid = fork();
+        if (pid == 0)
+        {
+            close(pipefd[0]);
+            // 客户端与服务端在同一进程，每个连接占两个fd
+            rlim_t limit = RaiseFdLimit(2 * n + 1024);
+            size_t want = limit > 1024 ? std::min(n, (size_t)(limit - 1024) / 2) : 0;
+            IdleSample sample = RunIdle(want, rounds);
+            write(pipefd[1], &sample, sizeof(sample));
+            _exit(0);
+        }
+        close(pipefd[1]);
+        IdleSample sample = {};
+        ssize_t got = read(pipefd[0], &sample, sizeof(sample));
+        close(pipefd[0]);
+        waitpid(pid, nullptr, 0);
+        if (got != sizeof(sample) || sample.rounds == 0)
+        {
+            fprintf(stderr, "idle.connections: run with %lu connections failed\n", n);
+            continue;
+        }
+
+        double conns = sample.established;
+        report.Add({"idle.connections", {{"requested", (double)n}, {"connections", conns}},
+                    (uint64_t)sample.rounds, sample.seconds,
+                    {{"rss_mb", sample.rss_after / 1048576.0},
+                     {"rss_bytes_per_conn", conns ? (sample.rss_after - sample.rss_before) / conns : 0},
+                     {"iterations", sample.iterations},
+                     {"cpu_ns_per_iteration", sample.iterations ? sample.cpu_ns / sample.iterations : 0},
+                     {"event_batch", sample.event_batch}}});
+    }
+}
+
+// ---------------- 连接缓冲池 ----------------
+// 与main.cc中MessageHandler一致：批量计算，响应直接写入输出缓冲区
+static void BenchBatchHandler(std::weak_ptr<Connection> wconn)
+{
+    auto connection = wconn.lock();
+    if (bench_sc.CalculatorBatch(connection->Inbuffer(), connection->OutTail(), connection->Frames()) == 0) return;
+    connection->el.lock()->Send(connection);
+}
+
+// 非阻塞读取已到达的响应，返回新读到的响应帧数（每帧两个分隔符）
+static size_t DrainResponses(int fd)
+{
+    char buf[65536];
+    size_t seps = 0;
+    ssize_t n;
+    while ((n = recv(fd, buf, sizeof(buf), MSG_DONTWAIT)) > 0)
+        for (ssize_t i = 0; i < n; ++i) seps += buf[i] == '\n';
+    return seps;
+}
+
+static void BenchBufferPool(BenchReport &report, bool quick)
+{
+    {
+        // 分配/释放：缓冲池与全局分配器对比
+        const size_t n = quick ? 200000 : 5000000;
+        for (size_t size : {1024, 65536})
+        {
+            BufferPool pool;
+            auto start = bench_clock::now();
+            for (size_t i = 0; i < n; ++i)
+            {
+                void *p = pool.allocate(size);
+                DoNotOptimize(p);
+                pool.deallocate(p, size);
+            }
+            report.Add({"buffer_pool.alloc_free", {{"bytes", (double)size}}, n, SecondsSince(start), {}});
+
+            start = bench_clock::now();
+            for (size_t i = 0; i < n; ++i)
+            {
+                void *p = ::operator new(size);
+                DoNotOptimize(p);
+                ::operator delete(p);
+            }
+            report.Add({"buffer_pool.new_delete", {{"bytes", (double)size}}, n, SecondsSince(start), {}});
+        }
+    }
+
+    // 突发后空闲：每个连接先收到一次大流水线突发，之后保持空闲
+    const size_t conns = quick ? 200 : 2000;
+    const size_t burst_frames = quick ? 4000 : 16000; // 约60KB / 240KB请求
+    const std::string burst = MakePipeline(burst_frames);
+    const size_t chunk = 32 * 1024;
+
+    std::shared_ptr<EventLoop> el(new EventLoop(nullptr, BenchBatchHandler));
+    std::vector<int> clients;
+    uint64_t rss_start = RssBytes();
+    auto start = bench_clock::now();
+    for (size_t c = 0; c < conns; ++c)
+    {
+        int sv[2];
+        if (socketpair(AF_UNIX, SOCK_STREAM, 0, sv) == -1) break;
+        SetNonBlockOrDie(sv[0]);
+        el->AddConnection(sv[0], EPOLLIN | EPOLLET,
+                          std::bind(&EventLoop::Recv, el, std::placeholders::_1),
+                          std::bind(&EventLoop::Send, el, std::placeholders::_1),
+                          std::bind(&EventLoop::Except, el, std::placeholders::_1));
+        clients.push_back(sv[1]);
+
+        size_t seps = 0;
+        for (size_t pos = 0; pos < burst.size(); pos += chunk)
+        {
+            size_t len = std::min(chunk, burst.size() - pos);
+            if (send(sv[1], burst.data() + pos, len, 0) != (ssize_t)len) break;
+            el->DisPatcher();
+            seps += DrainResponses(sv[1]);
+        }
+        // 服务端仍有未发完的响应时，读走后会产生可写事件
+        while (seps < burst_frames * 2)
+        {
+            el->DisPatcher();
+            seps += DrainResponses(sv[1]);
+        }
+    }
+    double seconds = SecondsSince(start);
+
+    BufferPoolStats stats = el->BufferStats();
+    uint64_t rss_idle = RssBytes();
+    size_t released = el->TrimBuffers();
+    uint64_t rss_trimmed = RssBytes();
+    report.Add({"buffer_pool.burst_then_idle", {{"connections", (double)clients.size()}, {"burst_bytes", (double)burst.size()}},
+                clients.size() * burst_frames, seconds,
+                {{"idle_buffer_bytes_per_conn", clients.empty() ? 0 : (double)stats.in_use_bytes / clients.size()},
+                 {"peak_buffer_mb", stats.peak_bytes / 1048576.0},
+                 {"cached_mb", stats.cached_bytes / 1048576.0},
+                 {"trimmed_mb", released / 1048576.0},
+                 {"rss_growth_idle_mb", ((double)rss_idle - rss_start) / 1048576.0},
+                 {"rss_growth_trimmed_mb", ((double)rss_trimmed - rss_start) / 1048576.0}}});
+
+    for (int fd : clients) close(fd);
+    while (el->ConnectionCount() > 0) el->DisPatcher(); // 处理对端关闭，回收服务端fd
+}
+
+// ---------------- 忙轮询 ----------------
+// 对比阻塞等待与忙轮询模式下单连接往返延迟，以及工作线程空转/处理时间占比
+static void BenchBusyPoll(BenchReport &report, bool quick)
+{
+    const size_t rounds = quick ? 2000 : 50000;
+    struct Mode
+    {
+        const char *name;
+        int spin_idle_us;
+    } modes[] = {
+        {"busy_poll.blocking", 0},
+        {"busy_poll.spin", default_spin_idle_us},
+    };
+
+    for (auto &mode : modes)
+    {
+        std::shared_ptr<Listener> tcp(new Listener(0));
+        BenchServer server(BenchMessageHandler);
+        if (mode.spin_idle_us) server.Worker()->EnableBusyPoll(mode.spin_idle_us);
+        server.AddListener(tcp);
+        server.Start();
+
+        struct sockaddr_in local;
+        socklen_t len = sizeof(local);
+        getsockname(tcp->Fd(), (struct sockaddr *)&local, &len);
+        int fd = ConnectTcp(ntohs(local.sin_port));
+        if (fd < 0 || !RoundTrips(fd, 1, 1))
+        {
+            if (fd >= 0) close(fd);
+            server.Stop();
+            continue;
+        }
+
+        std::vector<double> samples(rounds);
+        LoopStats before = server.Worker()->Stats();
+        auto start = bench_clock::now();
+        bool ok = true;
+        for (size_t r = 0; r < rounds && ok; ++r)
+        {
+            auto t = bench_clock::now();
+            ok = RoundTrips(fd, 1, 1);
+            samples[r] = SecondsSince(t) * 1e6;
+        }
+        double seconds = SecondsSince(start);
+        LoopStats after = server.Worker()->Stats();
+        close(fd);
+        server.Stop();
+        if (!ok) continue;
+
+        std::sort(samples.begin(), samples.end());
+        double spin = after.spin_ns - before.spin_ns;
+        double wait = after.wait_ns - before.wait_ns;
+        double work = after.work_ns - before.work_ns;
+        double total = spin + wait + work;
+        report.Add({mode.name, {{"spin_idle_us", (double)mode.spin_idle_us}}, rounds, seconds,
+                    {{"p50_us", samples[rounds / 2]},
+                     {"p99_us", samples[rounds * 99 / 100]},
+                     {"spin_polls", (double)(after.spin_polls - before.spin_polls)},
+                     {"empty_polls", (double)(after.empty_polls - before.empty_polls)},
+                     {"blocking_waits", (double)(after.blocking_waits - before.blocking_waits)},
+                     {"spin_ratio", total ? spin / total : 0},
+                     {"wait_ratio", total ? wait / total : 0},
+                     {"work_ratio", total ? work / total : 0}}});
+    }
+}
+
+// ---------------- 系统调用计数 ----------------
+// 与main.cc中MessageHandler一致：批量处理并登记请求数
+static void BenchCountingHandler(std::weak_ptr<Connection> wconn)
+{
+    auto connection = wconn.lock();
+    size_t n = bench_sc.CalculatorBatch(connection->Inbuffer(), connection->OutTail(), connection->Frames());
+    if (n == 0) return;
+    auto loop = connection->el.lock();
+    loop->CountRequests(n);
+    loop->Send(connection);
+}
+
+// 默认模式（按需增删EPOLLOUT、读到EAGAIN）与写事件常驻模式下每个请求的系统调用次数
+static void BenchSyscalls(BenchReport &report, bool quick)
+{
+    const size_t rounds = quick ? 1000 : 20000;
+    for (bool persistent : {false, true})
+    for (size_t depth : {1, 16, 128})
+    {
+        std::shared_ptr<Listener> tcp(new Listener(0));
+        BenchServer server(BenchCountingHandler);
+        if (persistent) server.Worker()->EnablePersistentOut();
+        server.AddListener(tcp);
+        server.Start();
+
+        struct sockaddr_in local;
+        socklen_t len = sizeof(local);
+        getsockname(tcp->Fd(), (struct sockaddr *)&local, &len);
+        int fd = ConnectTcp(ntohs(local.sin_port));
+        if (fd < 0 || !RoundTrips(fd, 1, 1))
+        {
+            if (fd >= 0) close(fd);
+            server.Stop();
+            continue;
+        }
+
+        size_t n = depth > 16 ? rounds / 8 : rounds;
+        SyscallStats before = server.Worker()->Syscalls();
+        auto start = bench_clock::now();
+        bool ok = RoundTrips(fd, n, depth);
+        double seconds = SecondsSince(start);
+        SyscallStats diff = server.Worker()->Syscalls() - before;
+        close(fd);
+        server.Stop();
+        if (!ok) continue;
+
+        std::vector<std::pair<std::string, double>> extra = {{"total_per_request", diff.PerRequest()}};
+        for (int k = 0; k < sys_kinds; ++k)
+            if (diff.calls[k]) extra.push_back({std::string(syscall_names[k]) + "_per_request", diff.PerRequest(k)});
+        report.Add({persistent ? "syscalls.persistent_out" : "syscalls.default", {{"pipeline_depth", (double)depth}},
+                    n * depth, seconds, extra});
+    }
+}
+
+// ---------------- HTTP/1.1 ----------------
+// 与main.cc中HttpMessageHandler一致
+static void BenchHttpHandler(std::weak_ptr<Connection> wconn)
+{
+    auto connection = wconn.lock();
+    bool close = false;
+    size_t n = bench_sc.CalculatorHttp(connection->Inbuffer(), connection->OutTail(), connection->Http(), close);
+    if (n == 0) return;
+    connection->close_after_send_ = close;
+    connection->el.lock()->Send(connection);
+}
+
+// n个流水线GET请求，首部与常见压测工具发出的相当
+static std::string MakeHttpPipeline(size_t n)
+{
+    static const char *ops[] = {"add", "sub", "mul", "div", "mod"};
+    std::string package;
+    for (size_t i = 0; i < n; ++i)
+    {
+        package += "GET /calc?x=" + std::to_string(i) + "&y=" + std::to_string(i % 7 + 1) + "&op=" + ops[i % 5] +
+                   " HTTP/1.1\r\nHost: 127.0.0.1:6667\r\nUser-Agent: bench\r\nAccept: */*\r\n\r\n";
+    }
+    return package;
+}
+
+// 读取expected个完整响应（按Content-Length定位正文结尾）
+static bool ReadHttpResponses(int fd, std::string &pending, size_t expected)
+{
+    char buf[16384];
+    size_t got = 0;
+    while (true)
+    {
+        while (got < expected)
+        {
+            size_t head = pending.find("\r\n\r\n");
+            if (head == std::string::npos) break;
+            size_t cl = pending.find("Content-Length: ");
+            if (cl == std::string::npos || cl > head) return false;
+            size_t end = head + 4 + std::stoul(pending.substr(cl + 16, head - cl - 16));
+            if (pending.size() < end) break;
+            pending.erase(0, end);
+            ++got;
+        }
+        if (got == expected) return true;
+        ssize_t n = recv(fd, buf, sizeof(buf), 0);
+        if (n <= 0) return false;
+        pending.append(buf, n);
+    }
+}
+
+static bool HttpRoundTrips(int fd, size_t rounds, size_t depth)
+{
+    const std::string batch = MakeHttpPipeline(depth);
+    std::string pending;
+    for (size_t r = 0; r < rounds; ++r)
+    {
+        if (send(fd, batch.data(), batch.size(), 0) != (ssize_t)batch.size()) return false;
+        if (!ReadHttpResponses(fd, pending, depth)) return false;
+    }
+    return true;
+}
+
+// 解析+计算+编码的单线程吞吐，以及keep-alive连接上与计算器协议的往返对比
+static void BenchHttp(BenchReport &report, bool quick)
+{
+    {
+        const size_t frames = 1000;
+        const size_t rounds = quick ? 20 : 500;
+        const std::string pipeline = MakeHttpPipeline(frames);
+        HttpParser parser;
+        std::string in, out;
+        bool close = false;
+        size_t handled = 0;
+        uint64_t refreshes = HttpHeaderCache::Local().Refreshes();
+        auto start = bench_clock::now();
+        for (size_t r = 0; r < rounds; ++r)
+        {
+            in = pipeline;
+            out.clear();
+            handled += bench_sc.CalculatorHttp(in, out, parser, close);
+        }
+        double seconds = SecondsSince(start);
+        if (handled == frames * rounds && !close)
+            report.Add({"http.calculator_batch", {{"pipeline", (double)frames}}, handled, seconds,
+                        {{"request_bytes", (double)pipeline.size() / frames},
+                         {"response_bytes", (double)out.size() / frames},
+                         {"date_refreshes", (double)(HttpHeaderCache::Local().Refreshes() - refreshes)}}});
+    }
+
+    const size_t rounds = quick ? 1000 : 20000;
+    for (bool http : {false, true})
+    for (size_t depth : {1, 16})
+    {
+        std::shared_ptr<Listener> tcp(new Listener(0));
+        BenchServer server(http ? BenchHttpHandler : BenchBatchHandler);
+        server.AddListener(tcp);
+        server.Start();
+
+        struct sockaddr_in local;
+        socklen_t len = sizeof(local);
+        getsockname(tcp->Fd(), (struct sockaddr *)&local, &len);
+        int fd = ConnectTcp(ntohs(local.sin_port));
+        auto trips = http ? HttpRoundTrips : RoundTrips;
+        if (fd < 0 || !trips(fd, 1, 1))
+        {
+            if (fd >= 0) close(fd);
+            server.Stop();
+            continue;
+        }
+        auto start = bench_clock::now();
+        bool ok = trips(fd, rounds, depth);
+        double seconds = SecondsSince(start);
+        close(fd);
+        server.Stop();
+        if (ok)
+            report.Add({http ? "http.keep_alive" : "http.framed_baseline", {{"pipeline_depth", (double)depth}},
+                        rounds * depth, seconds, {}});
+    }
+}
+
+// ---------------- 领导者/跟随者 ----------------
+// 耗时悬殊的处理器：操作符'~'的请求忙等x微秒（占CPU），'@'的请求睡眠x微秒（模拟同步磁盘或下游调用），
+// 其余按计算器处理
+struct BenchSkewHandler
+{
+    Response operator()(const Request &req)
+    {
+        if (req.op_ == '@')
+        {
+            std::this_thread::sleep_for(std::chrono::microseconds(req.x_));
+            return Response(req.x_, 0);
+        }
+        if (req.op_ != '~') return sc_.CalculatorHelper(req);
+        auto until = bench_clock::now() + std::chrono::microseconds(req.x_);
+        while (bench_clock::now() < until) {}
+        return Response(req.x_, 0);
+    }
+
+    ServerCal sc_;
+};
+
+// 4个工作线程、2个连接持续发送1ms的慢请求（占CPU或阻塞）、6个连接发送轻量请求（均为一问一答）：
+// 多reactor下连接按序号轮流固定到各循环，与慢连接同线程的轻量连接排在慢请求之后；
+// 共享epoll下任一空闲线程都能处理就绪的轻量连接
+static void BenchLeaderFollower(BenchReport &report, bool quick)
+{
+    using Loop = StaticEventLoop<BenchSkewHandler, CalcCodec>;
+    using Pool = LeaderFollowerPool<BenchSkewHandler, CalcCodec>;
+    const size_t threads = 4, heavy = 2, light = 6;
+    const int heavy_us = 1000;
+    const double seconds = quick ? 0.3 : 2.0;
+
+    for (bool blocking : {false, true})
+    for (bool shared : {false, true})
+    {
+        std::vector<std::shared_ptr<RingQueue<ClientInf>>> queues;
+        std::vector<std::unique_ptr<Loop>> loops;
+        std::vector<std::thread> servers;
+        std::unique_ptr<Pool> pool;
+        if (shared)
+        {
+            pool.reset(new Pool());
+            pool->SetIdleTimeout(0);
+            pool->Start(threads);
+        }
+        else
+        {
+            for (size_t i = 0; i < threads; ++i)
+            {
+                queues.emplace_back(new RingQueue<ClientInf>(16));
+                queues.back()->EnableNotify();  // 须在循环构造前开启
+                loops.emplace_back(new Loop(queues.back()));
+                loops.back()->SetIdleTimeout(0);
+            }
+            for (auto &loop : loops) servers.emplace_back([l = loop.get()]() { l->Loop(); });
+        }
+
+        std::vector<int> fds;
+        for (size_t i = 0; i < heavy + light; ++i)
+        {
+            int sv[2];
+            if (socketpair(AF_UNIX, SOCK_STREAM, 0, sv) == -1)
+            {
+                perror("socketpair");
+                break;
+            }
+            SetNonBlockOrDie(sv[0]);
+            if (shared) pool->AddConnection(sv[0], INADDR_ANY, 0, AF_UNIX);
+            else queues[i % threads]->Push(ClientInf{.sockfd = sv[0], .client_ip = INADDR_ANY, .client_port = 0, .family = AF_UNIX});
+            fds.push_back(sv[1]);
+        }
+
+        std::atomic<bool> stop{false};
+        std::atomic<bool> ok{true};
+        std::atomic<uint64_t> heavy_done{0};
+        std::vector<std::vector<double>> samples(fds.size());
+        std::vector<std::thread> clients;
+        for (size_t i = 0; i < fds.size(); ++i)
+        {
+            clients.emplace_back([&, i]() {
+                bool slow = i < heavy;
+                char op = slow ? (blocking ? '@' : '~') : '+';
+                std::string frame = Request(slow ? heavy_us : (int)i, 1, op).Serialize();
+                frame = Encode(frame);
+                std::string pending;
+                while (!stop.load(std::memory_order_relaxed))
+                {
+                    auto t = bench_clock::now();
+                    if (send(fds[i], frame.data(), frame.size(), 0) != (ssize_t)frame.size() ||
+                        !ReadResponses(fds[i], pending, 1))
+                    {
+                        ok = false;
+                        return;
+                    }
+                    if (slow) ++heavy_done;
+                    else samples[i].push_back(SecondsSince(t) * 1e6);
+                }
+            });
+        }
+        std::this_thread::sleep_for(std::chrono::duration<double>(seconds));
+        stop = true;
+        for (auto &client : clients) client.join();
+        for (int fd : fds) close(fd);
+
+        if (shared)
+        {
+            pool.reset();
+        }
+        else
+        {
+            for (auto &loop : loops) loop->Stop();
+            for (auto &server : servers) server.join();
+        }
+
+        // 与慢连接同线程的轻量连接完成的请求数明显更少，在合并的分位数中占比很小，单独报告最慢的一个
+        std::vector<double> all;
+        size_t min_conn_ops = SIZE_MAX;
+        for (size_t i = heavy; i < samples.size(); ++i)
+        {
+            all.insert(all.end(), samples[i].begin(), samples[i].end());
+            min_conn_ops = std::min(min_conn_ops, samples[i].size());
+        }
+        if (!ok || all.empty()) continue;
+        std::sort(all.begin(), all.end());
+        report.Add({shared ? "leader_follower.shared_epoll" : "leader_follower.multi_reactor",
+                    {{"threads", (double)threads}, {"heavy_conns", (double)heavy}, {"light_conns", (double)light},
+                     {"heavy_us", (double)heavy_us}, {"heavy_blocking", (double)blocking}},
+                    all.size(), seconds,
+                    {{"light_p50_us", all[all.size() / 2]},
+                     {"light_p99_us", all[all.size() * 99 / 100]},
+                     {"light_p999_us", all[all.size() * 999 / 1000]},
+                     {"light_max_us", all.back()},
+                     {"light_min_conn_ops", (double)min_conn_ops},
+                     {"heavy_ops", (double)heavy_done.load()}}});
+    }
+}
+
+// 客户端库：阻塞式一问一答基线 vs 连接池流水线（回调 / future）
+static void BenchClient(BenchReport &report, bool quick)
+{
+    const size_t requests = quick ? 20000 : 400000;
+    const size_t window = 256; // 每个提交线程的在途请求上限
+
+    std::shared_ptr<Listener> tcp(new Listener(0));
+    BenchServer server(BenchBatchHandler);
+    server.AddListener(tcp);
+    server.Start();
+
+    struct sockaddr_in local;
+    socklen_t len = sizeof(local);
+    getsockname(tcp->Fd(), (struct sockaddr *)&local, &len);
+    uint16_t port = ntohs(local.sin_port);
+
+    // 基线：单连接，每次发送一个请求并等待响应
+    {
+        size_t rounds = requests / 10;
+        int fd = ConnectTcp(port);
+        if (fd >= 0)
+        {
+            RoundTrips(fd, 1, 1);
+            auto start = bench_clock::now();
+            bool ok = RoundTrips(fd, rounds, 1);
+            double seconds = SecondsSince(start);
+            close(fd);
+            if (ok) report.Add({"client.blocking", {{"connections", 1}}, rounds, seconds, {}});
+        }
+    }
+
+    for (size_t conns : {1, 4})
+    {
+        ClientOpts opts;
+        opts.conns_per_thread = conns;
+        CalcClient client("127.0.0.1", port, opts);
+        client.Start();
+        if (!client.WaitConnected(conns, 3000)) continue;
+
+        // 回调：两个提交线程，各自限制在途请求数
+        const size_t submitters = 2;
+        std::atomic<size_t> done(0), failed(0);
+        uint64_t allocs = AllocCount();
+        auto start = bench_clock::now();
+        std::vector<std::thread> threads;
+        for (size_t t = 0; t < submitters; ++t)
+        {
+            threads.emplace_back([&]() {
+                std::atomic<size_t> finished(0);
+                size_t n = requests / submitters;
+                for (size_t i = 0; i < n; ++i)
+                {
+                    while (i - finished.load(std::memory_order_acquire) >= window) std::this_thread::yield();
+                    client.Submit(Request((int)i, 1, '+'), [&, i](bool ok, const Response &resp) {
+                        if (!ok || resp.res_ != (int)i + 1) failed.fetch_add(1, std::memory_order_relaxed);
+                        finished.fetch_add(1, std::memory_order_release);
+                    });
+                }
+                while (finished.load(std::memory_order_acquire) < n) std::this_thread::yield();
+                done.fetch_add(n, std::memory_order_relaxed);
+            });
+        }
+        for (auto &t : threads) t.join();
+        double seconds = SecondsSince(start);
+        report.Add({"client.pipelined_callback", {{"connections", (double)conns}, {"window", (double)window}},
+                    done.load(), seconds,
+                    {{"failed", (double)failed.load()},
+                     {"allocs_per_op", (double)(AllocCount() - allocs) / done.load()}}});
+
+        // future：每批提交window个请求后逐个等待
+        size_t total = requests / 4;
+        std::vector<std::future<std::optional<Response>>> futures;
+        futures.reserve(window);
+        size_t bad = 0;
+        start = bench_clock::now();
+        for (size_t i = 0; i < total; i += window)
+        {
+            futures.clear();
+            for (size_t j = 0; j < window; ++j) futures.push_back(client.Submit(Request((int)j, 2, '*')));
+            for (size_t j = 0; j < window; ++j)
+            {
+                auto resp = futures[j].get();
+                if (!resp || resp->res_ != (int)j * 2) ++bad;
+            }
+        }
+        seconds = SecondsSince(start);
+        size_t issued = (total + window - 1) / window * window;
+        report.Add({"client.pipelined_future", {{"connections", (double)conns}, {"window", (double)window}},
+                    issued, seconds, {{"failed", (double)bad}}});
+        client.Stop();
+    }
+
+    server.Stop();
+}
+
+// 准入控制：计数表热路径开销，以及单个来源洪泛时accept阶段的拒绝效果
+static void BenchAdmission(BenchReport &report, bool quick)
+{
+    const size_t n = quick ? 200000 : 5000000;
+    {
+        AdmissionOpts opts;
+        opts.max_conns_per_ip = 64;
+        AdmissionControl admission(opts);
+        auto start = bench_clock::now();
+        for (size_t i = 0; i < n; ++i)
+        {
+            uint32_t ip = htonl(0x0a000000 + (uint32_t)(i & 0xffff));
+            if (admission.AdmitConnection(ip)) admission.ReleaseConnection(ip);
+        }
+        report.Add({"admission.admit_release", {{"sources", 65536}}, n, SecondsSince(start), {}});
+    }
+    {
+        AdmissionOpts opts;
+        opts.req_rate = 1e6;
+        AdmissionControl admission(opts);
+        size_t admitted = 0;
+        auto start = bench_clock::now();
+        for (size_t i = 0; i < n; ++i)
+            admitted += admission.AdmitRequests(htonl(0x0a000001), 1);
+        report.Add({"admission.admit_requests", {{"req_rate", opts.req_rate}}, n, SecondsSince(start),
+                    {{"admitted", (double)admitted}}});
+    }
+
+    // 单个来源发起大量连接，上限之外的连接在accept阶段以RST拒绝，不进入工作线程
+    const size_t cap = 16;
+    const size_t attempts = quick ? 200 : 2000;
+    AdmissionOpts opts;
+    opts.max_conns_per_ip = cap;
+    std::shared_ptr<AdmissionControl> admission(new AdmissionControl(opts));
+    std::shared_ptr<Listener> tcp(new Listener(0));
+    tcp->SetAdmission(admission);
+    BenchServer server(BenchMessageHandler);
+    server.Worker()->SetAdmission(admission);
+    server.AddListener(tcp);
+    server.Start();
+
+    struct sockaddr_in local;
+    socklen_t len = sizeof(local);
+    getsockname(tcp->Fd(), (struct sockaddr *)&local, &len);
+    uint16_t port = ntohs(local.sin_port);
+
+    std::vector<int> fds;
+    size_t served = 0;
+    auto start = bench_clock::now();
+    for (size_t i = 0; i < attempts; ++i)
+    {
+        int fd = ConnectTcp(port);
+        if (fd < 0) continue;
+        // 被拒绝的连接收到RST，往返失败
+        if (RoundTrips(fd, 1, 1)) ++served;
+        fds.push_back(fd);
+    }
+    double seconds = SecondsSince(start);
+    AdmissionStats stats = admission->Stats();
+    for (int fd : fds) close(fd);
+    server.Stop();
+    report.Add({"admission.conn_flood", {{"attempts", (double)attempts}, {"cap", (double)cap}}, attempts, seconds,
+                {{"served", (double)served},
+                 {"admitted", (double)stats.admitted},
+                 {"rejected", (double)stats.rejected_conns}}});
+}
+
+// 交接队列满：暂停accept与快速拒绝两种策略下，连接突发的处理结果
+static void BenchOverload(BenchReport &report, bool quick)
+{
+    const size_t burst = quick ? 200 : 2000;
+    const size_t queue_cap = 4;
+    struct Mode
+    {
+        const char *name;
+        OverloadPolicy policy;
+    } modes[] = {
+        {"overload.pause", overload_pause},
+        {"overload.reject", overload_reject},
+    };
+    std::string busy;
+    Response(0, server_busy).SerializeTo(busy);
+    const std::string busy_content = Response(0, server_busy).Serialize();
+    for (auto &mode : modes)
+    {
+        std::shared_ptr<Listener> tcp(new Listener(0));
+        tcp->SetOverloadPolicy(mode.policy, busy);
+        BenchServer server(BenchMessageHandler, queue_cap);
+        server.AddListener(tcp);
+        server.Start();
+
+        struct sockaddr_in local;
+        socklen_t len = sizeof(local);
+        getsockname(tcp->Fd(), (struct sockaddr *)&local, &len);
+        uint16_t port = ntohs(local.sin_port);
+
+        // 先一次性建立全部连接，再逐个做一次往返
+        std::vector<int> fds;
+        auto start = bench_clock::now();
+        for (size_t i = 0; i < burst; ++i)
+        {
+            int fd = ConnectTcp(port);
+            if (fd >= 0) fds.push_back(fd);
+        }
+        size_t served = 0, busy_replies = 0, failed = 0;
+        const std::string req = MakePipeline(1);
+        for (int fd : fds)
+        {
+            std::string pending, content;
+            char buf[256];
+            bool ok = send(fd, req.data(), req.size(), MSG_NOSIGNAL) == (ssize_t)req.size();
+            while (ok && !Decode(pending, content))
+            {
+                ssize_t n = recv(fd, buf, sizeof(buf), 0);
+                if (n <= 0) ok = false;
+                else pending.append(buf, n);
+            }
+            if (!ok) ++failed;
+            else if (content == busy_content) ++busy_replies; // 被拒绝的连接收到“服务器忙”
+            else ++served;
+        }
+        double seconds = SecondsSince(start);
+        for (int fd : fds) close(fd);
+        report.Add({mode.name, {{"burst", (double)burst}, {"queue_cap", (double)queue_cap}}, fds.size(), seconds,
+                    {{"served", (double)served},
+                     {"busy_replies", (double)busy_replies},
+                     {"failed", (double)failed},
+                     {"queue_full", (double)server.Queue()->FullCount()},
+                     {"pauses", (double)tcp->Pauses()},
+                     {"rejected", (double)tcp->Rejected()}}});
+        server.Stop();
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    bool quick = false;
+    std::string filter;
+    std::string output;
+    int opt;
+    while ((opt = getopt(argc, argv, "qf:o:n:")) != -1)
+    {
+        switch (opt)
+        {
+        case 'q': quick = true; break;
+        case 'f': filter = optarg; break;
+        case 'o': output = optarg; break;
+        case 'n':
+        {
+            // 逗号分隔的空闲连接规模，如 -n 100000,1000000
+            std::string list = optarg;
+            size_t pos = 0;
+            while (pos < list.size())
+            {
+                size_t comma = list.find(',', pos);
+                if (comma == std::string::npos) comma = list.size();
+                idle_sizes.push_back(std::stoul(list.substr(pos, comma - pos)));
+                pos = comma + 1;
+            }
+            break;
+        }
+        default:
+            std::cerr << "Usage: " << argv[0] << " [-q] [-f filter] [-o output.json] [-n idle_sizes]" << std::endl;
+            return 1;
+        }
+    }
+
+    lg.Enable(Silent); // 避免日志干扰计时与JSON输出
+
+    struct Suite
+    {
+        const char *name;
+        void (*run)(BenchReport &, bool);
+    } suites[] = {
+        {"protocol", BenchProtocol},
+        {"ring_queue", BenchRingQueue},
+        {"timer_manager", BenchTimerManager},
+        {"timer_queue", BenchTimerQueue},
+        {"connection", BenchConnectionBuffer},
+        {"event_loop", BenchDispatcher},
+        {"static_loop", BenchStaticLoop},
+        {"trace", BenchTrace},
+        {"migrate", BenchMigrate},
+        {"transport", BenchTransport},
+        {"idle", BenchIdle},
+        {"busy_poll", BenchBusyPoll},
+        {"syscalls", BenchSyscalls},
+        {"http", BenchHttp},
+        {"leader_follower", BenchLeaderFollower},
+        {"buffer_pool", BenchBufferPool},
+        {"client", BenchClient},
+        {"admission", BenchAdmission},
+        {"overload", BenchOverload},
+    };
+
+    BenchReport report;
+    for (auto &suite : suites)
+    {
+        if (!filter.empty() && std::string(suite.name).find(filter) == std::string::npos)
+            continue;
+        suite.run(report, quick);
+    }
+
+    std::string json = report.ToJson();
+    if (output.empty())
+    {
+        fwrite(json.data(), 1, json.size(), stdout);
+    }
+    else
+    {
+        FILE *fp = fopen(output.c_str(), "w");
+        if (!fp)
+        {
+            perror("fopen");
+            return 1;
+        }
+        fwrite(json.data(), 1, json.size(), fp);
+        fclose(fp);
+    }
+    return 0;
+}
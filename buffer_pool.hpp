@@ -0,0 +1,144 @@
+#ifndef _BUFFER_POOL_HPP_
+#define _BUFFER_POOL_HPP_ 1
+
+#include <memory_resource>
+#include <cstddef>
+#include <cstdint>
+#include <malloc.h>
+#include "nocopy.hpp"
+
+inline const size_t pool_min_block = 64;          // 最小块大小（字节）
+inline const int pool_classes = 15;               // 64B ~ 1MB，按2的幂分级
+inline const size_t default_pool_cache = 4 << 20; // 每个池缓存空闲块的字节上限
+
+// 缓冲池统计
+struct BufferPoolStats
+{
+    uint64_t upstream_allocs; // 向全局分配器申请的次数
+    uint64_t upstream_frees;  // 归还全局分配器的次数
+    size_t in_use_bytes;      // 连接正在使用的字节数（按块大小计）
+    size_t peak_bytes;        // in_use_bytes的峰值
+    size_t cached_bytes;      // 池中缓存的空闲字节数
+    uint64_t trims;           // Trim次数
+};
+
+/**
+ * @brief 事件循环级的连接缓冲池
+ * @note 按2的幂分级的空闲链表，连接缓冲区清空后块回到池中供其他连接复用；
+ *       缓存超过上限的块直接归还全局分配器，Trim归还全部缓存块。
+ *       超过最大分级的请求直接走全局分配器。非线程安全，只能在所属EventLoop线程中使用
+ */
+class BufferPool : public std::pmr::memory_resource, public nocopy
+{
+public:
+    explicit BufferPool(size_t max_cached = default_pool_cache)
+        : max_cached_(max_cached),
+          stats_()
+    {
+        for (auto &head : free_) head = nullptr;
+    }
+
+    ~BufferPool()
+    {
+        Trim();
+    }
+
+    /**
+     * @brief 将缓存的空闲块全部归还全局分配器
+     * @return 归还的字节数
+     */
+    size_t Trim()
+    {
+        size_t released = 0;
+        for (int idx = 0; idx < pool_classes; ++idx)
+        {
+            while (Node *node = free_[idx])
+            {
+                free_[idx] = node->next;
+                ::operator delete(node);
+                released += BlockSize(idx);
+                ++stats_.upstream_frees;
+            }
+        }
+        stats_.cached_bytes = 0;
+        ++stats_.trims;
+        return released;
+    }
+
+    /// 设置缓存上限（字节）
+    void SetMaxCached(size_t bytes) { max_cached_ = bytes; }
+
+    BufferPoolStats Stats() const { return stats_; }
+
+private:
+    struct Node
+    {
+        Node *next;
+    };
+
+    static size_t BlockSize(int idx) { return pool_min_block << idx; }
+
+    // 请求大小对应的分级，超出最大分级返回pool_classes
+    static int ClassOf(size_t bytes, size_t align)
+    {
+        if (align > alignof(std::max_align_t)) return pool_classes;
+        int idx = 0;
+        while (idx < pool_classes && BlockSize(idx) < bytes) ++idx;
+        return idx;
+    }
+
+    void *do_allocate(size_t bytes, size_t align) override
+    {
+        int idx = ClassOf(bytes, align);
+        if (idx == pool_classes)
+        {
+            ++stats_.upstream_allocs;
+            return ::operator new(bytes, std::align_val_t(align));
+        }
+        size_t size = BlockSize(idx);
+        stats_.in_use_bytes += size;
+        if (stats_.in_use_bytes > stats_.peak_bytes) stats_.peak_bytes = stats_.in_use_bytes;
+        if (Node *node = free_[idx])
+        {
+            free_[idx] = node->next;
+            stats_.cached_bytes -= size;
+            return node;
+        }
+        ++stats_.upstream_allocs;
+        return ::operator new(size);
+    }
+
+    void do_deallocate(void *ptr, size_t bytes, size_t align) override
+    {
+        int idx = ClassOf(bytes, align);
+        if (idx == pool_classes)
+        {
+            ++stats_.upstream_frees;
+            ::operator delete(ptr, std::align_val_t(align));
+            return;
+        }
+        size_t size = BlockSize(idx);
+        stats_.in_use_bytes -= size;
+        if (stats_.cached_bytes + size > max_cached_)
+        {
+            ++stats_.upstream_frees;
+            ::operator delete(ptr);
+            return;
+        }
+        Node *node = static_cast<Node *>(ptr);
+        node->next = free_[idx];
+        free_[idx] = node;
+        stats_.cached_bytes += size;
+    }
+
+    bool do_is_equal(const std::pmr::memory_resource &other) const noexcept override
+    {
+        return this == &other;
+    }
+
+    Node *free_[pool_classes]; // 各分级的空闲链表
+    size_t max_cached_;        // 缓存上限
+    BufferPoolStats stats_;    // 统计
+};
+
+#endif
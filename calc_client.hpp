@@ -0,0 +1,437 @@
+#ifndef _CALC_CLIENT_HPP_
+#define _CALC_CLIENT_HPP_ 1
+
+#include <memory>
+#include <functional>
+#include <future>
+#include <optional>
+#include <deque>
+#include <vector>
+#include <string>
+#include <mutex>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include "log.hpp"
+#include "nocopy.hpp"
+#include "protocol.hpp"
+#include "connection.hpp"
+#include "event_loop.hpp"
+#include "connector.hpp"
+
+inline const size_t default_client_threads = 1; // 默认客户端事件循环线程数
+inline const size_t default_client_conns = 2;   // 默认每个线程的连接数
+inline const int client_idle_timeout = 86400;   // 客户端连接池的空闲超时（秒），实际上不回收
+inline const int default_backlog_timeout_ms = 3000; // 无可用连接时请求的最长等待时间（毫秒）
+
+/**
+ * @brief 计算器客户端配置
+ */
+struct ClientOpts
+{
+    size_t threads = default_client_threads;     // 事件循环线程数
+    size_t conns_per_thread = default_client_conns; // 每个线程维护的连接数
+    int backlog_timeout_ms = default_backlog_timeout_ms; // 无可用连接时请求最多等待多久
+    ConnectOpts connect;                         // 连接器配置
+};
+
+// 请求完成回调：ok为false表示连接断开或响应无法解析，在客户端事件循环线程中执行
+using calc_cb_t = std::function<void(bool ok, const Response &resp)>;
+
+/**
+ * @brief 单个客户端事件循环线程及其连接池
+ * @note Submit可从任意线程调用：请求先进入收件箱，每批只投递一次RunInLoop；
+ *       事件循环线程中按在途请求数最少的原则分配到连接，序列化到输出缓冲区尾部，
+ *       整批处理完后每个连接只发送一次。同一连接上的响应按请求顺序返回，
+ *       用FIFO匹配回调，实现流水线
+ */
+class ClientWorker : public nocopy
+{
+public:
+    ClientWorker(const sockaddr_in &server, size_t conns, const ClientOpts &opts)
+        : server_(server),
+          opts_(opts),
+          connected_(0),
+          dead_(0),
+          stopped_(false)
+    {
+        loop_.reset(new EventLoop(nullptr, [this](std::weak_ptr<Connection> conn) { OnMessage(conn); }));
+        loop_->SetIdleTimeout(client_idle_timeout);
+        for (size_t i = 0; i < conns; ++i)
+        {
+            std::unique_ptr<Slot> slot(new Slot());
+            slot->connector.reset(new Connector(loop_, server_, opts_.connect));
+            slots_.push_back(std::move(slot));
+        }
+    }
+
+    ~ClientWorker()
+    {
+        Stop();
+    }
+
+    /// 启动事件循环线程并开始连接
+    void Start()
+    {
+        thread_ = std::thread([loop = loop_]() { loop->Loop(); });
+        loop_->RunInLoop([this]() {
+            for (auto &slot : slots_)
+            {
+                Slot *s = slot.get();
+                s->connector->Start([this, s](int sockfd) { OnConnected(s, sockfd); });
+            }
+        });
+    }
+
+    /// 停止事件循环，关闭全部连接，未完成的请求以失败回调结束
+    void Stop()
+    {
+        if (stopped_.exchange(true)) return;
+        if (thread_.joinable())
+        {
+            loop_->Stop();
+            thread_.join();
+        }
+        // 事件循环线程已退出，此后在调用线程中清理
+        for (auto &slot : slots_)
+        {
+            slot->connector->Stop();
+            if (slot->conn) Close(slot.get());
+        }
+        std::vector<Pending> rest;
+        {
+            std::lock_guard<std::mutex> lock(mtx_);
+            rest.swap(inbox_);
+        }
+        for (auto &p : rest) p.cb(false, Response());
+        while (!backlog_.empty())
+        {
+            auto cb = std::move(backlog_.front().cb);
+            backlog_.pop_front();
+            cb(false, Response());
+        }
+    }
+
+    /// 提交请求（线程安全）
+    void Submit(const Request &req, calc_cb_t cb)
+    {
+        if (stopped_.load(std::memory_order_relaxed))
+        {
+            cb(false, Response());
+            return;
+        }
+        bool first;
+        {
+            std::lock_guard<std::mutex> lock(mtx_);
+            first = inbox_.empty();
+            inbox_.push_back({req, std::move(cb), 0});
+        }
+        // 收件箱非空说明已有一次Flush在排队，会一并处理本请求
+        if (first) loop_->QueueInLoop([this]() { Flush(); });
+    }
+
+    /// 已建立的连接数（可跨线程读取）
+    size_t Connected() { return connected_.load(std::memory_order_relaxed); }
+
+    /// 是否所有连接都已放弃重试（可跨线程读取）
+    bool GaveUp() { return dead_.load(std::memory_order_relaxed) == slots_.size(); }
+
+    std::shared_ptr<EventLoop> Loop() { return loop_; }
+
+private:
+    struct Pending
+    {
+        Request req;
+        calc_cb_t cb;
+        int64_t deadline; // 积压时的最晚等待时刻
+    };
+
+    struct Slot
+    {
+        std::shared_ptr<Connector> connector; // 负责建立与重建该连接
+        std::shared_ptr<Connection> conn;     // 已建立的连接，未连接时为空
+        std::deque<calc_cb_t> inflight;       // 已发送、等待响应的请求回调
+        bool dirty = false;                   // 本批是否有新数据待发送
+        bool dead = false;                    // 连接器已放弃重试
+    };
+
+    // 取出收件箱中的全部请求，分配到连接后每个连接发送一次
+    void Flush()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mtx_);
+            flushing_.swap(inbox_);
+        }
+        for (auto &p : flushing_) Dispatch(p);
+        flushing_.clear();
+        SendDirty();
+    }
+
+    void Dispatch(Pending &p)
+    {
+        Slot *best = nullptr;
+        for (auto &slot : slots_)
+        {
+            if (slot->conn && (!best || slot->inflight.size() < best->inflight.size()))
+                best = slot.get();
+        }
+        if (!best)
+        {
+            if (dead_ == slots_.size())
+            {
+                p.cb(false, Response()); // 全部连接已放弃，不再等待
+                return;
+            }
+            // 等待连接建立，超时后失败
+            p.deadline = EventLoop::NowMs() + opts_.backlog_timeout_ms;
+            backlog_.push_back(std::move(p));
+            if (!expire_scheduled_) ScheduleExpire(opts_.backlog_timeout_ms);
+            return;
+        }
+        p.req.SerializeTo(best->conn->OutTail());
+        best->inflight.push_back(std::move(p.cb));
+        best->dirty = true;
+    }
+
+    void SendDirty()
+    {
+        for (auto &slot : slots_)
+        {
+            if (!slot->dirty) continue;
+            slot->dirty = false;
+            if (slot->conn) loop_->Send(slot->conn); // 发送失败时经except_cb关闭并回调
+        }
+    }
+
+    void OnConnected(Slot *slot, int sockfd)
+    {
+        if (sockfd < 0)
+        {
+            slot->dead = true;
+            if (++dead_ == slots_.size())
+            {
+                // 所有连接都已放弃，等待中的请求直接失败
+                while (!backlog_.empty())
+                {
+                    auto cb = std::move(backlog_.front().cb);
+                    backlog_.pop_front();
+                    cb(false, Response());
+                }
+            }
+            return;
+        }
+        if (slot->dead)
+        {
+            slot->dead = false;
+            --dead_;
+        }
+        auto loop = loop_;
+        slot->conn = loop_->AddConnection(
+            sockfd, EPOLLIN | EPOLLET,
+            std::bind(&EventLoop::Recv, loop, std::placeholders::_1),
+            std::bind(&EventLoop::Send, loop, std::placeholders::_1),
+            [this, slot](std::weak_ptr<Connection>) { OnClosed(slot); },
+            server_.sin_addr.s_addr, ntohs(server_.sin_port));
+        connected_.fetch_add(1, std::memory_order_relaxed);
+
+        // 连接建立前积压的请求
+        std::deque<Pending> backlog;
+        backlog.swap(backlog_);
+        for (auto &p : backlog) Dispatch(p);
+        SendDirty();
+    }
+
+    // 积压超时的请求以失败结束，仍有积压时按队首的最晚时刻继续检查
+    void ExpireBacklog()
+    {
+        int64_t now = EventLoop::NowMs();
+        while (!backlog_.empty() && backlog_.front().deadline <= now)
+        {
+            auto cb = std::move(backlog_.front().cb);
+            backlog_.pop_front();
+            cb(false, Response());
+        }
+        expire_scheduled_ = false;
+        if (!backlog_.empty()) ScheduleExpire(backlog_.front().deadline - now);
+    }
+
+    void ScheduleExpire(int ms)
+    {
+        expire_scheduled_ = true;
+        loop_->RunAfter(ms, [this]() { ExpireBacklog(); });
+    }
+
+    // 解析响应并按顺序完成回调
+    void OnMessage(std::weak_ptr<Connection> wconn)
+    {
+        auto conn = wconn.lock();
+        Slot *slot = Find(conn.get());
+        if (!slot) return;
+        std::string content;
+        while (conn->NextFrame(content))
+        {
+            if (slot->inflight.empty())
+            {
+                lg(Warning, "unexpected response from [%s: %d]", conn->Ip(), conn->port_);
+                OnClosed(slot);
+                return;
+            }
+            Response resp;
+            bool ok = resp.Deserialize(content);
+            auto cb = std::move(slot->inflight.front());
+            slot->inflight.pop_front();
+            cb(ok, resp);
+            if (slot->conn != conn) return; // 回调中连接被关闭
+        }
+    }
+
+    // 连接断开：在途请求失败，按退避重连
+    void OnClosed(Slot *slot)
+    {
+        if (!slot->conn) return;
+        Close(slot);
+        if (!stopped_) slot->connector->Reconnect();
+    }
+
+    void Close(Slot *slot)
+    {
+        auto conn = std::move(slot->conn);
+        int fd = conn->Sockfd();
+        loop_->RemoveConnection(fd);
+        close(fd);
+        conn->ClearFiles();
+        conn->CancelWaiters();
+        connected_.fetch_sub(1, std::memory_order_relaxed);
+        std::deque<calc_cb_t> inflight;
+        inflight.swap(slot->inflight);
+        for (auto &cb : inflight) cb(false, Response());
+    }
+
+    Slot *Find(Connection *conn)
+    {
+        for (auto &slot : slots_)
+            if (slot->conn.get() == conn) return slot.get();
+        return nullptr;
+    }
+
+    struct sockaddr_in server_;                // 服务器地址
+    ClientOpts opts_;                          // 客户端配置
+    std::shared_ptr<EventLoop> loop_;          // 客户端事件循环
+    std::thread thread_;                       // 事件循环线程
+    std::vector<std::unique_ptr<Slot>> slots_; // 连接池
+    std::mutex mtx_;                           // 保护inbox_
+    std::vector<Pending> inbox_;               // 其他线程提交、尚未分配的请求
+    std::vector<Pending> flushing_;            // 正在分配的一批（与inbox_交换以复用容量）
+    std::deque<Pending> backlog_;              // 无可用连接时积压的请求
+    bool expire_scheduled_ = false;            // 是否已安排积压超时检查
+    std::atomic<size_t> connected_;            // 已建立的连接数
+    std::atomic<size_t> dead_;                 // 已放弃重试的连接数
+    std::atomic<bool> stopped_;                // 是否已停止
+};
+
+/**
+ * @brief 计算器服务的流水线客户端
+ * @note 若干事件循环线程，每个线程维护一组长连接；请求在线程间轮转，
+ *       同一连接上可同时有任意多个在途请求。示例：
+ *
+ *       CalcClient client("127.0.0.1", 8080);
+ *       client.Start();
+ *       client.Submit(Request(1, 2, '+'), [](bool ok, const Response &resp) { ... });
+ *       std::optional<Response> resp = client.Submit(Request(3, 4, '*')).get();
+ */
+class CalcClient : public nocopy
+{
+public:
+    CalcClient(const std::string &server_ip, uint16_t server_port, ClientOpts opts = ClientOpts())
+        : next_(0)
+    {
+        struct sockaddr_in server;
+        bzero(&server, sizeof(server));
+        server.sin_family = AF_INET;
+        server.sin_port = htons(server_port);
+        inet_pton(AF_INET, server_ip.c_str(), &server.sin_addr);
+        size_t threads = opts.threads ? opts.threads : 1;
+        size_t conns = opts.conns_per_thread ? opts.conns_per_thread : 1;
+        for (size_t i = 0; i < threads; ++i)
+            workers_.emplace_back(new ClientWorker(server, conns, opts));
+    }
+
+    ~CalcClient()
+    {
+        Stop();
+    }
+
+    /// 启动事件循环线程并开始连接
+    void Start()
+    {
+        for (auto &worker : workers_) worker->Start();
+    }
+
+    /// 停止全部线程，未完成的请求以失败结束
+    void Stop()
+    {
+        for (auto &worker : workers_) worker->Stop();
+    }
+
+    /**
+     * @brief 提交请求，完成后在客户端事件循环线程中回调（线程安全）
+     * @note 回调中不要阻塞；可以继续调用Submit
+     */
+    void Submit(const Request &req, calc_cb_t cb)
+    {
+        size_t idx = next_.fetch_add(1, std::memory_order_relaxed) % workers_.size();
+        workers_[idx]->Submit(req, std::move(cb));
+    }
+
+    /**
+     * @brief 提交请求并返回future（线程安全）
+     * @return 成功时为响应，连接断开或响应无法解析时为nullopt
+     */
+    std::future<std::optional<Response>> Submit(const Request &req)
+    {
+        auto promise = std::make_shared<std::promise<std::optional<Response>>>();
+        auto future = promise->get_future();
+        Submit(req, [promise](bool ok, const Response &resp) {
+            if (ok) promise->set_value(resp);
+            else promise->set_value(std::nullopt);
+        });
+        return future;
+    }
+
+    /**
+     * @brief 等待至少n个连接建立
+     * @return 超时或全部连接放弃重试前达到返回true
+     */
+    bool WaitConnected(size_t n, int timeout_ms)
+    {
+        int64_t deadline = EventLoop::NowMs() + timeout_ms;
+        while (Connected() < n)
+        {
+            if (EventLoop::NowMs() >= deadline || GaveUp()) return false;
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        return true;
+    }
+
+    /// 已建立的连接总数
+    size_t Connected()
+    {
+        size_t n = 0;
+        for (auto &worker : workers_) n += worker->Connected();
+        return n;
+    }
+
+    /// 是否所有线程的连接都已放弃重试
+    bool GaveUp()
+    {
+        for (auto &worker : workers_)
+            if (!worker->GaveUp()) return false;
+        return true;
+    }
+
+private:
+    std::vector<std::unique_ptr<ClientWorker>> workers_; // 事件循环线程
+    std::atomic<size_t> next_;                           // 轮转下标
+};
+
+#endif
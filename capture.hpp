@@ -0,0 +1,246 @@
+#ifndef _CAPTURE_HPP_
+#define _CAPTURE_HPP_ 1
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <algorithm>
+#include <cstring>
+#include <cstdint>
+#include <fcntl.h>
+#include <unistd.h>
+#include "log.hpp"
+#include "nocopy.hpp"
+
+/**
+ * 流量录制文件格式（小端）：
+ *   文件头: "RCAP" + 版本号(u32)
+ *   记录:   类型(u8) + 连接号(varint) + 时间戳(varint，相对录制开始的微秒) [+ 长度(varint) + 数据]
+ * 各工作线程的记录按块整体写入，不同线程的块之间按时间交错，同一连接的记录保持顺序
+ */
+inline const char capture_magic[4] = {'R', 'C', 'A', 'P'};
+inline const uint32_t capture_version = 1;
+inline const size_t capture_flush_bytes = 64 * 1024; // 线程缓冲达到该大小时写入文件
+inline const int capture_flush_ms = 1000;            // 缓冲中的记录最长停留时间（毫秒）
+
+enum
+{
+    capture_open_error = 1,
+};
+
+// 记录类型
+enum CaptureType : uint8_t
+{
+    capture_connect = 1, // 新连接
+    capture_data,        // 收到的数据
+    capture_close,       // 连接关闭
+};
+
+// 录制文件中的一条记录
+struct CaptureEvent
+{
+    CaptureType type;
+    uint32_t conn;     // 连接号（录制内唯一）
+    uint64_t ts_us;    // 相对录制开始的微秒数
+    std::string data;  // capture_data的内容
+};
+
+/**
+ * @brief 录制文件写入端，多个工作线程共享
+ * @note 记录先写入各线程的CaptureStream，按块加锁追加到文件，热路径上只有内存拷贝
+ */
+class CaptureWriter : public nocopy
+{
+public:
+    explicit CaptureWriter(const std::string &path)
+        : start_(std::chrono::steady_clock::now()), next_id_(1), bytes_(0)
+    {
+        fd_ = open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_APPEND | O_CLOEXEC, 0644);
+        if (fd_ == -1)
+        {
+            lg(Fatal, "open capture file %s false, errno: %d, errstr: %s", path.c_str(), errno, strerror(errno));
+            exit(capture_open_error);
+        }
+        std::string header(capture_magic, sizeof(capture_magic));
+        header.append((const char *)&capture_version, sizeof(capture_version));
+        Write(header);
+        lg(Info, "capture traffic to %s", path.c_str());
+    }
+
+    ~CaptureWriter() { close(fd_); }
+
+    /// 分配连接号
+    uint32_t NextId() { return next_id_.fetch_add(1, std::memory_order_relaxed); }
+
+    /// 相对录制开始的微秒数
+    uint64_t Now()
+    {
+        return std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now() - start_).count();
+    }
+
+    /// 追加一块记录（线程安全）
+    void Write(const std::string &block)
+    {
+        std::lock_guard<std::mutex> lock(mtx_);
+        size_t done = 0;
+        while (done < block.size())
+        {
+            ssize_t n = write(fd_, block.data() + done, block.size() - done);
+            if (n > 0) done += n;
+            else if (n == -1 && errno == EINTR) continue;
+            else
+            {
+                lg(Error, "write capture file false, errno: %d, errstr: %s", errno, strerror(errno));
+                return;
+            }
+        }
+        bytes_ += done;
+    }
+
+    /// 已写入文件的字节数
+    uint64_t Bytes()
+    {
+        std::lock_guard<std::mutex> lock(mtx_);
+        return bytes_;
+    }
+
+private:
+    int fd_;
+    std::mutex mtx_;                              // 保证每块连续写入
+    std::chrono::steady_clock::time_point start_; // 录制开始时间
+    std::atomic<uint32_t> next_id_;               // 下一个连接号
+    uint64_t bytes_;                              // 已写入字节数
+};
+
+/**
+ * @brief 单个事件循环的录制缓冲，只能在所属线程使用
+ */
+class CaptureStream : public nocopy
+{
+public:
+    explicit CaptureStream(std::shared_ptr<CaptureWriter> writer) : writer_(writer)
+    {
+        buf_.reserve(capture_flush_bytes + 4096);
+    }
+
+    ~CaptureStream() { Flush(); }
+
+    /// 记录新连接，返回其连接号
+    uint32_t Connect()
+    {
+        uint32_t id = writer_->NextId();
+        Head(capture_connect, id);
+        return id;
+    }
+
+    /// 记录连接收到的数据
+    void Data(uint32_t id, const char *data, size_t len)
+    {
+        Head(capture_data, id);
+        PutVarint(len);
+        buf_.append(data, len);
+        if (buf_.size() >= capture_flush_bytes) Flush();
+    }
+
+    /// 记录连接关闭
+    void Close(uint32_t id) { Head(capture_close, id); }
+
+    /// 缓冲中的记录写入文件
+    void Flush()
+    {
+        if (buf_.empty()) return;
+        writer_->Write(buf_);
+        buf_.clear();
+    }
+
+private:
+    void Head(CaptureType type, uint32_t id)
+    {
+        buf_.push_back((char)type);
+        PutVarint(id);
+        PutVarint(writer_->Now());
+    }
+
+    void PutVarint(uint64_t v)
+    {
+        while (v >= 0x80)
+        {
+            buf_.push_back((char)(v | 0x80));
+            v >>= 7;
+        }
+        buf_.push_back((char)v);
+    }
+
+    std::shared_ptr<CaptureWriter> writer_;
+    std::string buf_; // 尚未写入文件的记录
+};
+
+/**
+ * @brief 读取录制文件，记录按时间排序（同一时刻保持文件顺序，同一连接的顺序不变）
+ * @return 文件不存在或格式错误时返回false；末尾不完整的记录被忽略
+ */
+inline bool LoadCapture(const std::string &path, std::vector<CaptureEvent> &events)
+{
+    int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd == -1)
+    {
+        lg(Error, "open capture file %s false, errno: %d, errstr: %s", path.c_str(), errno, strerror(errno));
+        return false;
+    }
+    std::string file;
+    char chunk[65536];
+    ssize_t n;
+    while ((n = read(fd, chunk, sizeof(chunk))) > 0) file.append(chunk, n);
+    close(fd);
+
+    size_t header = sizeof(capture_magic) + sizeof(capture_version);
+    uint32_t version = 0;
+    if (file.size() < header || memcmp(file.data(), capture_magic, sizeof(capture_magic)) != 0 ||
+        (memcpy(&version, file.data() + sizeof(capture_magic), sizeof(version)), version != capture_version))
+    {
+        lg(Error, "%s is not a capture file", path.c_str());
+        return false;
+    }
+
+    size_t pos = header;
+    auto varint = [&](uint64_t &v) {
+        v = 0;
+        for (int shift = 0; pos < file.size() && shift < 64; shift += 7)
+        {
+            uint8_t b = file[pos++];
+            v |= (uint64_t)(b & 0x7f) << shift;
+            if (!(b & 0x80)) return true;
+        }
+        return false;
+    };
+    while (pos < file.size())
+    {
+        CaptureEvent ev;
+        ev.type = (CaptureType)file[pos++];
+        uint64_t conn, ts, len;
+        if (!varint(conn) || !varint(ts)) break;
+        ev.conn = (uint32_t)conn;
+        ev.ts_us = ts;
+        if (ev.type == capture_data)
+        {
+            if (!varint(len) || len > file.size() - pos) break;
+            ev.data.assign(file, pos, len);
+            pos += len;
+        }
+        else if (ev.type != capture_connect && ev.type != capture_close)
+        {
+            lg(Error, "bad capture record type %d at offset %lu", ev.type, pos - 1);
+            return false;
+        }
+        events.push_back(std::move(ev));
+    }
+    std::stable_sort(events.begin(), events.end(),
+                     [](const CaptureEvent &a, const CaptureEvent &b) { return a.ts_us < b.ts_us; });
+    return true;
+}
+
+#endif
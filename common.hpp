@@ -3,6 +3,8 @@
 
 #include <unistd.h>
 #include <fcntl.h>
+#include <sys/resource.h>
+#include <cstdio>
 #include <iostream>
 #include <functional>
 
@@ -19,4 +21,46 @@ void SetNonBlockOrDie(int sock)
     fcntl(sock, F_SETFL, fl | O_NONBLOCK);
 }
 
+/**
+ * @brief 提高进程可打开的文件描述符上限
+ * @param want 期望的上限，0表示尽可能提高到硬上限
+ *        （有权限时再尝试把硬上限提高到/proc/sys/fs/nr_open）
+ * @return 调整后的软上限
+ */
+rlim_t RaiseFdLimit(rlim_t want = 0)
+{
+    struct rlimit rl;
+    if (getrlimit(RLIMIT_NOFILE, &rl) == -1)
+        return 0;
+
+    if (want == 0 || want > rl.rlim_max)
+    {
+        // 尝试提高硬上限（需要CAP_SYS_RESOURCE）
+        rlim_t nr_open = 0;
+        FILE *fp = fopen("/proc/sys/fs/nr_open", "r");
+        if (fp)
+        {
+            unsigned long v;
+            if (fscanf(fp, "%lu", &v) == 1) nr_open = v;
+            fclose(fp);
+        }
+        rlim_t target = want ? want : nr_open;
+        if (target > rl.rlim_max)
+        {
+            struct rlimit raised = {target, target};
+            if (setrlimit(RLIMIT_NOFILE, &raised) == 0)
+                return target;
+        }
+    }
+
+    rlim_t target = (want == 0 || want > rl.rlim_max) ? rl.rlim_max : want;
+    if (target > rl.rlim_cur)
+    {
+        rl.rlim_cur = target;
+        if (setrlimit(RLIMIT_NOFILE, &rl) == -1)
+            return 0;
+    }
+    return rl.rlim_cur;
+}
+
 #endif
\ No newline at end of file
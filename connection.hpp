@@ -5,7 +5,18 @@
 #include <iostream>
 #include <memory>       // 智能指针支持
 #include <functional>   // 函数对象支持
+#include <optional>
+#include <utility>
+#include <deque>
+#include <string_view>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <coroutine>    // 协程句柄
+#include <arpa/inet.h>  // inet_ntop
 #include "common.hpp"   // 项目通用头文件
+#include "protocol.hpp" // 帧索引
+#include "http.hpp"     // HTTP请求解析器
+#include "buffer_pool.hpp" // 连接缓冲池
 
 class Connection;
 // Connection类的前向声明，用于func_t类型定义
@@ -18,43 +29,235 @@ using func_t = std::function<void(std::weak_ptr<Connection>)>;
 class EventLoop; 
 // EventLoop类的前向声明
 
-class Connection{
+// 连接缓冲区类型：内存来自所属EventLoop的缓冲池
+using buffer_t = std::pmr::string;
+
+inline const size_t buffer_keep_bytes = 4096; // 缓冲区容量超过该值且大多空闲时收缩
+
+class FrameAwaiter;
+class WriteAwaiter;
+// 协程等待体的前向声明（定义见coroutine.hpp）
+
+class ShmChannel;
+// 共享内存传输通道的前向声明（定义见shm_ring.hpp）
+
+/**
+ * @brief 待发送的文件区间
+ * @note 由EventLoop::Send通过sendfile（普通文件）或splice（管道）零拷贝发送
+ */
+struct FileRegion{
+    int fd;            // 文件描述符
+    off_t offset;      // 当前发送偏移
+    size_t length;     // 剩余待发送字节数
+    bool owns_fd;      // 发送完毕或连接关闭时是否负责close
+    bool is_pipe;      // 管道使用splice，其余使用sendfile
+    bool pipe_wait;    // 管道已空、写端未关闭：管道fd已注册到epoll等待可读
+    buffer_t tail;     // 排在该文件之后追加的内存数据
+};
+
+class Connection: public std::enable_shared_from_this<Connection>{
 public:
     // 构造函数：初始化socket描述符，默认不关注写事件
-    Connection(int sock)
+    // pool为空时缓冲区使用默认分配器
+    Connection(int sock, std::shared_ptr<BufferPool> pool = nullptr)
     :sock_(sock),
-    write_care_(false){}
+    pool_(pool),
+    inbuffer_(Resource()),
+    outbuffer_(Resource()),
+    addr_(INADDR_ANY),
+    port_(0),
+    family_(AF_INET),
+    capture_id_(0),
+    rx_bytes_(0),
+    write_care_(false),
+    writable_(true),
+    rdhup_(false),
+    close_after_send_(false),
+    read_slot_(nullptr),
+    co_started_(false),
+    closed_(false){}
 
     // 获取socket文件描述符
     int Sockfd(){ return sock_; }
 
     // 追加数据到输入缓冲区
-    void AppendInBuffer(const std::string &info)
+    void AppendInBuffer(std::string_view info)
     {
         inbuffer_ += info;
     }
 
+    ~Connection()
+    {
+        ClearFiles();
+    }
+
     // 追加数据到输出缓冲区
-    void AppendOutBuffer(const std::string &info)
+    // 若已有排队的文件区间，数据排在最后一个文件之后，保证发送顺序
+    void AppendOutBuffer(std::string_view info)
+    {
+        if(files_.empty()) outbuffer_ += info;
+        else files_.back().tail += info;
+    }
+
+    // 获取当前追加输出的缓冲区：无排队文件时为输出缓冲区，否则为最后一个文件之后的数据
+    // 可直接在其尾部原地序列化，省去AppendOutBuffer的一次拷贝
+    buffer_t &OutTail()
+    {
+        return files_.empty() ? outbuffer_ : files_.back().tail;
+    }
+
+    /**
+     * @brief 追加文件区间到输出队列
+     * @param fd 文件或管道描述符
+     * @param offset 起始偏移（管道忽略）
+     * @param length 发送字节数
+     * @param owns_fd 为true时由连接负责关闭fd
+     */
+    void AppendFile(int fd, off_t offset, size_t length, bool owns_fd = false)
+    {
+        struct stat st;
+        bool is_pipe = fstat(fd, &st) == 0 && S_ISFIFO(st.st_mode);
+        files_.push_back(FileRegion{fd, offset, length, owns_fd, is_pipe, false, buffer_t(Resource())});
+    }
+
+    // 是否还有待发送的文件区间
+    bool HasFile() { return !files_.empty(); }
+
+    // 队首文件区间（输出缓冲区清空后发送）
+    FileRegion &FrontFile() { return files_.front(); }
+
+    // 队首文件发送完毕：其后的内存数据成为新的输出缓冲区
+    void PopFile()
+    {
+        FileRegion &region = files_.front();
+        if(region.owns_fd) close(region.fd);
+        outbuffer_.swap(region.tail);
+        files_.pop_front();
+    }
+
+    // 丢弃所有待发送文件（连接关闭时调用）
+    void ClearFiles()
     {
-        outbuffer_ += info;
+        for(auto &region : files_)
+            if(region.owns_fd) close(region.fd);
+        files_.clear();
     }
 
+    // 输出是否已全部发送（内存数据和文件区间）
+    bool OutEmpty() { return outbuffer_.empty() && files_.empty(); }
+
     // 获取输入缓冲区引用
-    std::string &Inbuffer()
+    buffer_t &Inbuffer()
     {
         return inbuffer_;
     }
 
+    // 输入缓冲区的帧索引；通过索引取帧时不要再以其他方式删除输入缓冲区数据
+    FrameIndex &Frames()
+    {
+        return frames_;
+    }
+
+    // 输入缓冲区的HTTP解析器（首次使用时创建，其他协议的连接不占用内存）
+    HttpParser &Http()
+    {
+        if(!http_) http_.reset(new HttpParser());
+        return *http_;
+    }
+
+    // 从输入缓冲区取出下一个完整帧，无完整帧时移除已取出的数据
+    bool NextFrame(std::string &content)
+    {
+        if(frames_.Next(inbuffer_, content)) return true;
+        frames_.Compact(inbuffer_);
+        return false;
+    }
+
     // 获取输出缓冲区引用
-    std::string &OutBuffer()
+    buffer_t &OutBuffer()
     {
         return outbuffer_;
     }
+
+    // 空闲缓冲区归还缓冲池：清空的缓冲区释放全部内存，
+    // 大部分已消费的大缓冲区收缩到实际大小，避免一次突发长期占用内存
+    void ReleaseIdleBuffers()
+    {
+        Shrink(inbuffer_);
+        Shrink(outbuffer_);
+        if(inbuffer_.empty()) frames_.Release();
+    }
+
+    /**
+     * @brief 缓冲区改用另一个缓冲池（pool为空时使用默认分配器），内容与帧索引不变
+     * @note 旧缓冲区的内存归还原缓冲池，须在原缓冲池所属线程调用；
+     *       连接跨线程迁移时先在源线程改用默认分配器，再在目标线程改用目标缓冲池
+     */
+    void Rehome(std::shared_ptr<BufferPool> pool)
+    {
+        auto old = std::exchange(pool_, pool);  // 旧缓冲区析构前保持原缓冲池有效
+        Rebind(inbuffer_);
+        Rebind(outbuffer_);
+        for(auto &region : files_) Rebind(region.tail);
+    }
+
+    // 获取客户端IP字符串，首次调用时才格式化（accept路径不做字符串转换）
+    const char *Ip()
+    {
+        if(family_ == AF_UNIX) return "unix";
+        if(ip_.empty())
+        {
+            char buf[INET_ADDRSTRLEN];
+            struct in_addr in;
+            in.s_addr = addr_;
+            inet_ntop(AF_INET, &in, buf, sizeof(buf));
+            ip_ = buf;
+        }
+        return ip_.c_str();
+    }
+
+    // 协程接口（定义见coroutine.hpp）
+    // co_await ReadFrame(): 等待下一个完整协议帧，连接关闭时得到nullopt
+    FrameAwaiter ReadFrame();
+    // co_await Write(data): 写入并等待输出缓冲区清空，连接已关闭时得到false
+    WriteAwaiter Write(const std::string &data);
+
+    // 连接关闭时唤醒所有挂起的协程
+    void CancelWaiters()
+    {
+        closed_ = true;
+        if(read_waiter_) std::exchange(read_waiter_, nullptr).resume();
+        if(write_waiter_) std::exchange(write_waiter_, nullptr).resume();
+    }
 private:
+    std::pmr::memory_resource *Resource()
+    {
+        return pool_ ? pool_.get() : std::pmr::get_default_resource();
+    }
+
+    // 以当前缓冲池重建缓冲区（pmr字符串的分配器不能通过赋值更换）
+    void Rebind(buffer_t &buffer)
+    {
+        buffer_t moved(buffer, Resource());
+        std::destroy_at(&buffer);
+        std::construct_at(&buffer, std::move(moved));
+    }
+
+    static void Shrink(buffer_t &buffer)
+    {
+        // 空缓冲区收缩回短字符串存储（已是短字符串时为空操作）
+        if(buffer.empty() || (buffer.capacity() > buffer_keep_bytes && buffer.size() * 4 < buffer.capacity()))
+            buffer.shrink_to_fit();
+    }
+
     int sock_;              // 套接字文件描述符
-    std::string inbuffer_;  // 输入数据缓冲区
-    std::string outbuffer_; // 输出数据缓冲区
+    std::shared_ptr<BufferPool> pool_; // 缓冲池（须先于缓冲区构造、后于缓冲区析构）
+    buffer_t inbuffer_;     // 输入数据缓冲区
+    FrameIndex frames_;     // 输入缓冲区的分隔符索引
+    std::unique_ptr<HttpParser> http_; // 输入缓冲区的HTTP解析器（惰性创建）
+    buffer_t outbuffer_;    // 输出数据缓冲区
+    std::deque<FileRegion> files_; // 输出缓冲区之后排队的文件区间
+    std::string ip_;        // 客户端IP字符串缓存（惰性生成）
 
 public:
     // 所属EventLoop的弱引用（避免循环引用）
@@ -66,11 +269,25 @@ public:
     func_t except_cb;  // 异常事件回调
 
     // 客户端信息
-    std::string ip_;     // 客户端IP地址
+    uint32_t addr_;      // 客户端IPv4地址（网络字节序）
     uint16_t port_;      // 客户端端口号
+    sa_family_t family_; // 地址族：AF_INET或AF_UNIX（同机客户端）
+    uint32_t capture_id_; // 流量录制中的连接号，0表示未录制
+    uint64_t rx_bytes_;   // 本统计周期收到的字节数（负载均衡据此挑选迁移的连接）
+    std::shared_ptr<ShmChannel> shm_; // 共享内存传输通道，为空表示经socket收发（此时sockfd为本端通知eventfd）
     
     // 写事件关注标志
     // true表示需要监听EPOLLOUT事件
     bool write_care_;  
+    bool writable_;    // 常驻写事件模式下是否可写（send遇到EAGAIN后为false，EPOLLOUT到达后恢复）
+    bool rdhup_;       // 对端已关闭写方向（EPOLLRDHUP），须读到0
+    bool close_after_send_; // 输出全部发送后关闭连接（如HTTP的Connection: close），此后的输入不再处理
+
+    // 协程状态：等待帧/等待写完成的协程句柄
+    std::coroutine_handle<> read_waiter_;
+    std::coroutine_handle<> write_waiter_;
+    std::optional<std::string> *read_slot_; // 等待帧时解码结果的存放位置
+    bool co_started_;  // 是否已为该连接启动协程处理器
+    bool closed_;      // 连接是否已关闭
 };
 #endif
\ No newline at end of file
@@ -0,0 +1,280 @@
+#ifndef _CONNECTOR_HPP_
+#define _CONNECTOR_HPP_ 1
+
+#include <memory>
+#include <functional>
+#include <algorithm>
+#include <cerrno>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include "log.hpp"
+#include "tcp.hpp"
+#include "nocopy.hpp"
+#include "connection.hpp"
+#include "event_loop.hpp"
+
+inline const int default_connect_timeout_ms = 3000; // 单次连接超时（毫秒）
+inline const int default_retry_delay_ms = 100;      // 首次重试间隔（毫秒），之后指数退避
+inline const int default_max_retry_delay_ms = 5000; // 重试间隔上限（毫秒）
+
+/**
+ * @brief 连接器配置
+ */
+struct ConnectOpts
+{
+    int timeout_ms = default_connect_timeout_ms;
+    int retry_delay_ms = default_retry_delay_ms;
+    int max_retry_delay_ms = default_max_retry_delay_ms;
+    int max_retries = -1; // 连续失败多少次后放弃，小于0表示一直重试
+    SockOpts sock;        // 连接建立后设置的socket选项
+};
+
+// 连接结果回调：成功时为已连接的非阻塞fd（所有权交给回调），放弃重试时为-1
+using connect_cb_t = std::function<void(int sockfd)>;
+
+/**
+ * @brief 非阻塞连接器
+ * @note 在EventLoop线程中发起非阻塞connect，等待EPOLLOUT后用SO_ERROR确认结果；
+ *       超时、被拒绝等失败按指数退避重试。所有方法只能在所属EventLoop线程中调用
+ */
+class Connector : public std::enable_shared_from_this<Connector>, public nocopy
+{
+public:
+    Connector(std::shared_ptr<EventLoop> loop, const sockaddr_in &server, ConnectOpts opts = ConnectOpts())
+        : loop_(loop),
+          server_(server),
+          opts_(opts),
+          state_(idle),
+          sockfd_(-1),
+          delay_ms_(opts.retry_delay_ms),
+          retries_(0),
+          timer_(0)
+    {
+    }
+
+    ~Connector()
+    {
+        if (sockfd_ >= 0) close(sockfd_);
+    }
+
+    /// 开始连接，结果通过cb通知
+    void Start(connect_cb_t cb)
+    {
+        cb_ = cb;
+        Restart();
+    }
+
+    /// 连接断开后重新连接：先按当前退避间隔等待，避免对端重启期间频繁重连
+    void Reconnect()
+    {
+        if (state_ == connecting || state_ == waiting) return;
+        state_ = waiting;
+        ScheduleRetry();
+    }
+
+    /// 立即重新开始连接（重置退避）
+    void Restart()
+    {
+        Cancel();
+        delay_ms_ = opts_.retry_delay_ms;
+        retries_ = 0;
+        Connect();
+    }
+
+    /// 停止连接：取消进行中的连接与等待中的重试
+    void Stop()
+    {
+        Cancel();
+        state_ = idle;
+    }
+
+    /// 连续失败次数
+    int Retries() const { return retries_; }
+
+    /// 是否正在连接或等待重试
+    bool Pending() const { return state_ == connecting || state_ == waiting; }
+
+private:
+    enum State
+    {
+        idle,       // 未连接
+        connecting, // 等待connect完成
+        waiting,    // 等待下一次重试
+    };
+
+    void Connect()
+    {
+        int sockfd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        if (sockfd == -1)
+        {
+            lg(Error, "socket false, errno: %d, errstr: %s", errno, strerror(errno));
+            Retry(-1);
+            return;
+        }
+        int ret = connect(sockfd, (struct sockaddr *)&server_, sizeof(server_));
+        int err = ret == 0 ? 0 : errno;
+        switch (err)
+        {
+        case 0:
+        case EINPROGRESS:
+        case EINTR:
+        case EISCONN:
+            Wait(sockfd);
+            break;
+        case EAGAIN:
+        case EADDRINUSE:
+        case EADDRNOTAVAIL:
+        case ECONNREFUSED:
+        case ENETUNREACH:
+        case EHOSTUNREACH:
+        case ETIMEDOUT:
+            lg(Warning, "connect to [%s: %d] false, errno: %d, errstr: %s", Ip(), Port(), err, strerror(err));
+            Retry(sockfd);
+            break;
+        default:
+            // 地址或权限错误，重试也无法成功
+            lg(Error, "connect to [%s: %d] false, errno: %d, errstr: %s", Ip(), Port(), err, strerror(err));
+            close(sockfd);
+            state_ = idle;
+            if (cb_) cb_(-1);
+            break;
+        }
+    }
+
+    // 注册写事件等待连接完成，同时启动超时
+    void Wait(int sockfd)
+    {
+        state_ = connecting;
+        sockfd_ = sockfd;
+        std::weak_ptr<Connector> self = shared_from_this();
+        auto handler = [self](std::weak_ptr<Connection>) {
+            if (auto connector = self.lock()) connector->OnWritable();
+        };
+        // 不加入空闲定时器：超时由连接器自己的定时器控制
+        loop_->AddConnection(sockfd, EPOLLOUT | EPOLLET, nullptr, handler, nullptr,
+                             server_.sin_addr.s_addr, Port(), true);
+
+        timer_ = loop_->RunAfter(opts_.timeout_ms, [self]() {
+            auto connector = self.lock();
+            if (!connector || connector->state_ != connecting) return;
+            connector->timer_ = 0;
+            lg(Warning, "connect to [%s: %d] timeout", connector->Ip(), connector->Port());
+            connector->Retry(connector->Detach());
+        });
+    }
+
+    // 可写或出错：根据SO_ERROR判断连接结果
+    void OnWritable()
+    {
+        if (state_ != connecting) return;
+        int sockfd = Detach();
+        int err = 0;
+        socklen_t len = sizeof(err);
+        if (getsockopt(sockfd, SOL_SOCKET, SO_ERROR, &err, &len) == -1) err = errno;
+        if (err != 0)
+        {
+            lg(Warning, "connect to [%s: %d] false, errno: %d, errstr: %s", Ip(), Port(), err, strerror(err));
+            Retry(sockfd);
+            return;
+        }
+        if (SelfConnect(sockfd))
+        {
+            // 本地临时端口恰好等于目标端口时可能连上自己
+            lg(Warning, "self connect to [%s: %d]", Ip(), Port());
+            Retry(sockfd);
+            return;
+        }
+
+        CancelTimer(); // 取消本次连接的超时
+        state_ = idle;
+        delay_ms_ = opts_.retry_delay_ms;
+        retries_ = 0;
+        Sock::ApplyConnOpts(sockfd, opts_.sock);
+        lg(Info, "connect to [%s: %d] success, sockfd: %d", Ip(), Port(), sockfd);
+        if (cb_) cb_(sockfd);
+        else close(sockfd);
+    }
+
+    // 从事件循环摘除正在连接的socket并交出fd
+    int Detach()
+    {
+        int sockfd = sockfd_;
+        sockfd_ = -1;
+        loop_->RemoveConnection(sockfd);
+        return sockfd;
+    }
+
+    // 关闭失败的socket，超过重试次数则放弃，否则按退避间隔重试
+    void Retry(int sockfd)
+    {
+        if (sockfd >= 0) close(sockfd);
+        CancelTimer();
+        ++retries_;
+        if (opts_.max_retries >= 0 && retries_ > opts_.max_retries)
+        {
+            lg(Error, "connect to [%s: %d] give up after %d retries", Ip(), Port(), retries_ - 1);
+            state_ = idle;
+            if (cb_) cb_(-1);
+            return;
+        }
+        state_ = waiting;
+        ScheduleRetry();
+    }
+
+    void ScheduleRetry()
+    {
+        std::weak_ptr<Connector> self = shared_from_this();
+        timer_ = loop_->RunAfter(delay_ms_, [self]() {
+            auto connector = self.lock();
+            if (!connector || connector->state_ != waiting) return;
+            connector->timer_ = 0;
+            connector->Connect();
+        });
+        delay_ms_ = std::min(delay_ms_ * 2, opts_.max_retry_delay_ms);
+    }
+
+    // 取消进行中的连接与已安排的重试
+    void Cancel()
+    {
+        CancelTimer();
+        if (state_ == connecting) close(Detach());
+    }
+
+    // 取消连接超时或重试定时器
+    void CancelTimer()
+    {
+        if (timer_) loop_->Cancel(timer_);
+        timer_ = 0;
+    }
+
+    bool SelfConnect(int sockfd)
+    {
+        struct sockaddr_in local, peer;
+        socklen_t len = sizeof(local);
+        if (getsockname(sockfd, (struct sockaddr *)&local, &len) == -1) return false;
+        len = sizeof(peer);
+        if (getpeername(sockfd, (struct sockaddr *)&peer, &len) == -1) return false;
+        return local.sin_port == peer.sin_port && local.sin_addr.s_addr == peer.sin_addr.s_addr;
+    }
+
+    const char *Ip()
+    {
+        inet_ntop(AF_INET, &server_.sin_addr, ip_, sizeof(ip_));
+        return ip_;
+    }
+
+    int Port() { return ntohs(server_.sin_port); }
+
+    std::shared_ptr<EventLoop> loop_; // 所属事件循环
+    struct sockaddr_in server_;       // 服务器地址
+    ConnectOpts opts_;                // 配置
+    connect_cb_t cb_;                 // 连接结果回调
+    State state_;                     // 当前状态
+    int sockfd_;                      // 正在连接的socket
+    int delay_ms_;                    // 下一次重试间隔
+    int retries_;                     // 连续失败次数
+    timer_id_t timer_;                // 连接超时或重试定时器，0表示没有
+    char ip_[INET_ADDRSTRLEN];        // 日志用地址字符串
+};
+
+#endif
@@ -0,0 +1,239 @@
+#ifndef _COROUTINE_HPP_
+#define _COROUTINE_HPP_ 1
+
+#include <coroutine>
+#include <optional>
+#include <string>
+#include <memory>
+#include <exception>
+#include "log.hpp"
+#include "connection.hpp"
+#include "event_loop.hpp"
+#include "protocol.hpp"
+
+/**
+ * 基于EventLoop的C++20协程接口
+ *
+ * 用法：
+ *   CoTask Handler(std::shared_ptr<Connection> conn)
+ *   {
+ *       while (auto frame = co_await conn->ReadFrame())
+ *       {
+ *           ...
+ *           if (!co_await conn->Write(Encode(out))) co_return;
+ *       }
+ *   }
+ *   new EventLoop(rq, CoMessageHandler(Handler), TaskPush);
+ *
+ * 协程总是在连接所属EventLoop线程中被恢复；
+ * 等待体保存在协程帧内，挂起/恢复本身不产生堆分配，协程帧来自线程本地内存池
+ */
+
+inline constexpr size_t frame_align = 64;        // 协程帧按64字节分级
+inline constexpr size_t frame_classes = 64;      // 池化的最大帧为 64 * 64 = 4KB
+inline constexpr size_t frame_cache_limit = 1024; // 每级最多缓存的空闲帧数
+
+/**
+ * @brief 协程帧内存池
+ * @note 每线程按大小分级的空闲链表，协程帧在同一EventLoop线程内反复复用
+ */
+class FramePool
+{
+public:
+    static void *Allocate(size_t size)
+    {
+        size_t idx = Index(size);
+        if (idx >= frame_classes)
+            return ::operator new(size);
+        Node *node = free_[idx];
+        if (node)
+        {
+            free_[idx] = node->next;
+            --count_[idx];
+            return node;
+        }
+        return ::operator new((idx + 1) * frame_align);
+    }
+
+    static void Deallocate(void *ptr, size_t size)
+    {
+        size_t idx = Index(size);
+        if (idx >= frame_classes || count_[idx] >= frame_cache_limit)
+        {
+            ::operator delete(ptr);
+            return;
+        }
+        Node *node = static_cast<Node *>(ptr);
+        node->next = free_[idx];
+        free_[idx] = node;
+        ++count_[idx];
+    }
+
+private:
+    struct Node
+    {
+        Node *next;
+    };
+
+    static size_t Index(size_t size) { return (size + frame_align - 1) / frame_align - 1; }
+
+    static inline thread_local Node *free_[frame_classes] = {};
+    static inline thread_local size_t count_[frame_classes] = {};
+};
+
+/**
+ * @brief 即发即弃的协程任务类型
+ * @note 创建后立即运行到第一个挂起点，结束时自动销毁协程帧
+ */
+struct CoTask
+{
+    struct promise_type
+    {
+        CoTask get_return_object() { return {}; }
+        std::suspend_never initial_suspend() noexcept { return {}; }
+        std::suspend_never final_suspend() noexcept { return {}; }
+        void return_void() {}
+        void unhandled_exception()
+        {
+            lg(Fatal, "thread-%d, uncaught exception in coroutine handler", pthread_self());
+            std::terminate();
+        }
+
+        static void *operator new(size_t size) { return FramePool::Allocate(size); }
+        static void operator delete(void *ptr, size_t size) { FramePool::Deallocate(ptr, size); }
+    };
+};
+
+/**
+ * @brief 等待一个完整协议帧
+ */
+class FrameAwaiter
+{
+public:
+    explicit FrameAwaiter(Connection *conn)
+        : conn_(conn) {}
+
+    bool await_ready()
+    {
+        if (conn_->closed_) return true;
+        std::string content;
+        if (!conn_->NextFrame(content)) return false;
+        frame_ = std::move(content);
+        return true;
+    }
+
+    void await_suspend(std::coroutine_handle<> handle)
+    {
+        // 由CoMessageHandler在新数据到达后解码并恢复
+        conn_->read_slot_ = &frame_;
+        conn_->read_waiter_ = handle;
+    }
+
+    std::optional<std::string> await_resume()
+    {
+        conn_->read_slot_ = nullptr;
+        return std::move(frame_);
+    }
+
+private:
+    Connection *conn_;
+    std::optional<std::string> frame_;
+};
+
+/**
+ * @brief 写入数据并等待输出缓冲区发送完毕
+ */
+class WriteAwaiter
+{
+public:
+    WriteAwaiter(Connection *conn, const std::string &data)
+        : conn_(conn), data_(data) {}
+
+    bool await_ready()
+    {
+        if (conn_->closed_) return true;
+        conn_->AppendOutBuffer(data_);
+        auto loop = conn_->el.lock();
+        loop->Send(conn_->shared_from_this());
+        // Send过程中可能发现连接异常并关闭
+        return conn_->closed_ || conn_->OutEmpty();
+    }
+
+    void await_suspend(std::coroutine_handle<> handle)
+    {
+        // 由EventLoop::Send在缓冲区清空后恢复
+        conn_->write_waiter_ = handle;
+    }
+
+    bool await_resume() { return !conn_->closed_; }
+
+private:
+    Connection *conn_;
+    const std::string &data_;
+};
+
+/**
+ * @brief 在所属EventLoop上休眠指定毫秒
+ */
+class SleepAwaiter
+{
+public:
+    SleepAwaiter(EventLoop *loop, int ms)
+        : loop_(loop), ms_(ms) {}
+
+    bool await_ready() { return ms_ <= 0; }
+
+    void await_suspend(std::coroutine_handle<> handle)
+    {
+        loop_->ResumeAt(EventLoop::NowMs() + ms_, handle);
+    }
+
+    void await_resume() {}
+
+private:
+    EventLoop *loop_;
+    int ms_;
+};
+
+inline FrameAwaiter Connection::ReadFrame()
+{
+    return FrameAwaiter(this);
+}
+
+inline WriteAwaiter Connection::Write(const std::string &data)
+{
+    return WriteAwaiter(this, data);
+}
+
+inline SleepAwaiter EventLoop::Sleep(int ms)
+{
+    return SleepAwaiter(this, ms);
+}
+
+// 协程处理器类型：每个连接首次收到数据时启动一次
+using co_handler_t = CoTask (*)(std::shared_ptr<Connection>);
+
+/**
+ * @brief 将协程处理器适配为EventLoop的OnMessage回调
+ * @note 首条消息到达时启动协程；之后每次收到数据，若协程正在等待帧则尝试解码并恢复
+ */
+inline func_t CoMessageHandler(co_handler_t handler)
+{
+    return [handler](std::weak_ptr<Connection> wconnection) {
+        auto connection = wconnection.lock();
+        if (!connection->co_started_)
+        {
+            connection->co_started_ = true;
+            handler(connection);
+            return;
+        }
+        if (!connection->read_waiter_) return; // 协程正在休眠或等待写完成
+
+        std::string content;
+        if (!connection->NextFrame(content)) return;
+        *connection->read_slot_ = std::move(content);
+        std::exchange(connection->read_waiter_, nullptr).resume();
+    };
+}
+
+#endif
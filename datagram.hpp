@@ -0,0 +1,166 @@
+#ifndef _DATAGRAM_HPP_
+#define _DATAGRAM_HPP_ 1
+
+#include <iostream>
+#include <memory>
+#include <vector>
+#include <string>
+#include <functional>
+#include <sys/socket.h>
+#include "tcp.hpp"         // socket封装
+#include "connection.hpp"  // 注册到EventLoop时使用的连接对象
+#include "log.hpp"
+
+inline const int default_datagram_batch = 64;     // 每次唤醒最多收取的数据报数
+inline const size_t max_datagram_size = 2048;     // 单个数据报最大长度
+
+// 数据报处理函数：request为收到的数据报内容，需要回复时将数据追加到reply
+using datagram_handler_t = std::function<void(std::string &request, std::string &reply)>;
+
+/**
+ * @brief UDP数据报端点
+ * @note 作为监听类fd注册到EventLoop，可读时用recvmmsg批量收取，
+ *       处理完毕后用sendmmsg批量回复。每个EventLoop绑定一个SO_REUSEPORT socket，
+ *       由内核在各线程之间分流
+ */
+class DatagramEndpoint
+{
+public:
+    /**
+     * @brief 构造函数
+     * @param port 绑定端口号
+     * @param handler 数据报处理函数
+     * @param batch 每次recvmmsg/sendmmsg的最大数据报数
+     */
+    DatagramEndpoint(uint16_t port, datagram_handler_t handler, int batch = default_datagram_batch)
+        : port_(port),
+        batch_(batch),
+        handler_(handler),
+        sock_(new Sock()),
+        inbuf_(batch * max_datagram_size),
+        in_msgs_(batch),
+        in_iov_(batch),
+        peers_(batch),
+        replies_(batch),
+        out_msgs_(batch),
+        out_iov_(batch)
+    {
+    }
+
+    /**
+     * @brief 创建并绑定非阻塞UDP socket
+     */
+    void Init()
+    {
+        sock_->Socket(SOCK_DGRAM | SOCK_NONBLOCK);
+        SockOpts opts;
+        opts.reuse_port = true; // 每个EventLoop一个socket共享端口
+        Sock::ApplyListenOpts(sock_->GetSockfd(), opts);
+        sock_->Bind(port_);
+
+        // 接收端的iovec与地址缓冲区一次性准备好，之后每批复用
+        for (int i = 0; i < batch_; ++i)
+        {
+            in_iov_[i].iov_base = &inbuf_[i * max_datagram_size];
+            in_iov_[i].iov_len = max_datagram_size;
+        }
+    }
+
+    /**
+     * @brief 可读事件回调：批量收取、处理并回复
+     * @note 边缘触发下循环直到EAGAIN
+     */
+    void Reader(std::weak_ptr<Connection>)
+    {
+        int sockfd = sock_->GetSockfd();
+        while (true)
+        {
+            for (int i = 0; i < batch_; ++i)
+            {
+                struct msghdr &hdr = in_msgs_[i].msg_hdr;
+                hdr.msg_name = &peers_[i];
+                hdr.msg_namelen = sizeof(peers_[i]);
+                hdr.msg_iov = &in_iov_[i];
+                hdr.msg_iovlen = 1;
+                hdr.msg_control = nullptr;
+                hdr.msg_controllen = 0;
+                hdr.msg_flags = 0;
+            }
+
+            int n = recvmmsg(sockfd, in_msgs_.data(), batch_, MSG_DONTWAIT, nullptr);
+            if (n == -1)
+            {
+                if (errno == EWOULDBLOCK) break;
+                else if (errno == EINTR) continue;
+                lg(Error, "recvmmsg false, errno: %d, errstr: %s", errno, strerror(errno));
+                break;
+            }
+
+            // 逐个处理，收集需要回复的数据报
+            int replies = 0;
+            for (int i = 0; i < n; ++i)
+            {
+                if (in_msgs_[i].msg_hdr.msg_flags & MSG_TRUNC)
+                {
+                    lg(Warning, "datagram larger than %lu bytes dropped", max_datagram_size);
+                    continue;
+                }
+                request_.assign((char *)in_iov_[i].iov_base, in_msgs_[i].msg_len);
+                std::string &reply = replies_[replies];
+                reply.clear();
+                handler_(request_, reply);
+                if (reply.empty()) continue;
+
+                out_iov_[replies].iov_base = reply.data();
+                out_iov_[replies].iov_len = reply.size();
+                struct msghdr &hdr = out_msgs_[replies].msg_hdr;
+                hdr = msghdr();
+                hdr.msg_name = &peers_[i];
+                hdr.msg_namelen = in_msgs_[i].msg_hdr.msg_namelen;
+                hdr.msg_iov = &out_iov_[replies];
+                hdr.msg_iovlen = 1;
+                ++replies;
+            }
+            SendReplies(sockfd, replies);
+
+            if (n < batch_) break; // 未收满一批说明接收队列已空
+        }
+    }
+
+    /// 获取UDP socket文件描述符
+    int Fd() { return sock_->GetSockfd(); }
+
+private:
+    // 用sendmmsg批量发送回复，发送缓冲区满时丢弃剩余回复（UDP语义）
+    void SendReplies(int sockfd, int count)
+    {
+        int sent = 0;
+        while (sent < count)
+        {
+            int n = sendmmsg(sockfd, &out_msgs_[sent], count - sent, MSG_DONTWAIT);
+            if (n == -1)
+            {
+                if (errno == EINTR) continue;
+                lg(Warning, "sendmmsg false, %d replies dropped, errno: %d, errstr: %s",
+                   count - sent, errno, strerror(errno));
+                return;
+            }
+            sent += n;
+        }
+    }
+
+    uint16_t port_;                        // 绑定端口
+    int batch_;                            // 批量大小
+    datagram_handler_t handler_;           // 数据报处理函数
+    std::shared_ptr<Sock> sock_;           // UDP socket封装对象
+    std::vector<char> inbuf_;              // 接收缓冲区（batch个槽位）
+    std::vector<struct mmsghdr> in_msgs_;  // recvmmsg消息头
+    std::vector<struct iovec> in_iov_;     // 接收iovec
+    std::vector<struct sockaddr_in> peers_; // 对端地址
+    std::string request_;                  // 当前处理的数据报（复用容量）
+    std::vector<std::string> replies_;     // 回复内容（复用容量）
+    std::vector<struct mmsghdr> out_msgs_; // sendmmsg消息头
+    std::vector<struct iovec> out_iov_;    // 发送iovec
+};
+
+#endif
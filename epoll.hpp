@@ -3,12 +3,25 @@
 
 #include <iostream>
 #include <sys/epoll.h>  // epoll系统调用头文件
+#include <sys/ioctl.h>
 #include "nocopy.hpp"   // 禁止拷贝的基类
 #include "log.hpp"      // 日志系统头文件
 
 // 默认epoll_wait超时时间(毫秒)
 inline const int default_time_out = 3000;
 
+// epoll实例级忙轮询参数（Linux 6.9+），旧版本头文件中没有时按内核ABI自行定义
+#ifndef EPIOCSPARAMS
+struct epoll_params {
+    uint32_t busy_poll_usecs;  // 每次epoll_wait在网卡队列上忙轮询的微秒数
+    uint16_t busy_poll_budget; // 每次忙轮询最多处理的数据包数
+    uint8_t prefer_busy_poll;  // 优先忙轮询，推迟软中断处理
+    uint8_t __pad;
+};
+#define EPOLL_IOC_TYPE 0x8A
+#define EPIOCSPARAMS _IOW(EPOLL_IOC_TYPE, 0x01, struct epoll_params)
+#endif
+
 // 错误码枚举
 enum {
     epoll_create_error = 1,  // epoll创建失败错误码
@@ -46,7 +59,16 @@ public:
      */
     int EpollWait(struct epoll_event events[], int num)
     {
-        int n = epoll_wait(epfd, events, num, timeout);
+        return EpollWait(events, num, timeout);
+    }
+
+    /**
+     * @brief 以指定超时等待epoll事件
+     * @param wait_ms 本次等待的超时时间(毫秒)，-1表示无限等待
+     */
+    int EpollWait(struct epoll_event events[], int num, int wait_ms)
+    {
+        int n = epoll_wait(epfd, events, num, wait_ms);
         if(n == -1){
             lg(Error, "epoll_wait false, errno: %d, errstr: %s", errno, strerror(errno));
         }
@@ -78,6 +100,47 @@ public:
         }
     }
 
+    /**
+     * @brief 以指针作为事件数据注册或修改fd（多个线程共享同一epoll时用于直接找到连接状态）
+     * @return 成功返回true
+     */
+    bool EpollCtl(int op, int fd, uint32_t event, void *ptr)
+    {
+        struct epoll_event ev;
+        ev.data.ptr = ptr;
+        ev.events = event;
+        if(epoll_ctl(epfd, op, fd, &ev)){
+            lg(Error, "epoll control false, errno: %d, errstr: %s",
+               errno, strerror(errno));
+            return false;
+        }
+        return true;
+    }
+
+    /**
+     * @brief 设置epoll实例的内核忙轮询参数
+     * @param usecs 每次epoll_wait忙轮询的微秒数，0为关闭
+     * @param budget 每次忙轮询最多处理的数据包数
+     * @param prefer 是否优先忙轮询
+     * @return 内核不支持或权限不足时返回false
+     */
+    bool SetBusyPoll(uint32_t usecs, uint16_t budget, bool prefer)
+    {
+        struct epoll_params params = {};
+        params.busy_poll_usecs = usecs;
+        params.busy_poll_budget = budget;
+        params.prefer_busy_poll = prefer;
+        if(ioctl(epfd, EPIOCSPARAMS, &params) == -1){
+            lg(Warning, "epoll busy poll unsupported, errno: %d, errstr: %s",
+               errno, strerror(errno));
+            return false;
+        }
+        return true;
+    }
+
+    /// 获取默认超时时间(毫秒)
+    int Timeout() { return timeout; }
+
     /**
      * @brief 析构函数：关闭epoll文件描述符
      */
@@ -5,13 +5,33 @@
 #include <unordered_map>
 #include <memory>
 #include <functional>
+#include <utility>
+#include <queue>
+#include <vector>
+#include <algorithm>
+#include <chrono>
+#include <coroutine>
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/sendfile.h>
+#include <sys/eventfd.h>
 #include "tcp.hpp"
 #include "epoll.hpp"
 #include "log.hpp"
 #include "common.hpp"
 #include "ring_queue.hpp"
 #include "timer_manager.hpp"
+#include "timer_queue.hpp"
 #include "connection.hpp"
+#include "arena.hpp"
+#include "buffer_pool.hpp"
+#include "admission.hpp"
+#include "capture.hpp"
+#include "trace.hpp"
+#include "shm_ring.hpp"
 
 // 前向声明
 class Connection;      // 连接类
@@ -19,19 +39,109 @@ class EventLoop;       // 事件循环类
 struct ClientInf;      // 客户端信息结构体
 class Timer;          // 定时器类
 class TimerManager;   // 定时器管理类
+class SleepAwaiter;   // 协程休眠等待体（定义见coroutine.hpp）
 
 // 定义任务类型：接收环形队列和事件循环的弱指针
 using task_t = std::function<void(std::weak_ptr<RingQueue<ClientInf>>, std::weak_ptr<EventLoop>)>;
 
-inline constexpr size_t max_fd = 1 << 10;  // 最大文件描述符数量
+inline constexpr size_t min_event_batch = 1 << 6;   // epoll_wait单批事件数下限
+inline constexpr size_t max_event_batch = 1 << 16;  // epoll_wait单批事件数上限
+inline constexpr int shrink_rounds = 64;            // 连续多少轮低负载后缩小批量
+inline const int default_spin_idle_us = 1000;      // 忙轮询模式下连续无事件多久后退回阻塞等待（微秒）
+inline const uint16_t default_busy_poll_budget = 8; // 内核忙轮询每次处理的数据包数
 inline const uint16_t default_port = 7777; // 默认端口号
-inline thread_local char buffer[1024];     // 线程本地接收缓冲区
+inline const size_t max_migrate_batch = 64;  // 每次再均衡最多迁出的连接数
+inline thread_local char buffer[16 * 1024]; // 线程本地接收缓冲区
+
+// 事件循环运行统计（各字段为累计值）
+struct LoopStats{
+    uint64_t spin_polls;     // 零超时epoll_wait次数
+    uint64_t empty_polls;    // 其中未取到事件的次数
+    uint64_t blocking_waits; // 阻塞epoll_wait次数
+    uint64_t spin_ns;        // 空转耗时：零超时轮询及未取到事件的轮次
+    uint64_t wait_ns;        // 阻塞在epoll_wait中的耗时
+    uint64_t work_ns;        // 处理事件、新连接与定时器的耗时
+    uint64_t migrated_in;    // 从其他事件循环迁入的连接数
+    uint64_t migrated_out;   // 迁往其他事件循环的连接数
+};
+
+// 系统调用分类（EventLoop::Syscalls）
+enum SyscallKind{
+    sys_epoll_wait,   // epoll_wait
+    sys_epoll_ctl,    // epoll_ctl（增删改）
+    sys_recv,         // recv
+    sys_recv_eagain,  // 其中返回EAGAIN的recv
+    sys_send,         // send
+    sys_send_eagain,  // 其中返回EAGAIN的send
+    sys_sendfile,     // sendfile/splice
+    sys_eventfd,      // 唤醒、任务队列与共享内存通知的eventfd读写
+    sys_accept,       // accept4（监听循环）
+    sys_kinds
+};
+
+inline const char *const syscall_names[sys_kinds] = {
+    "epoll_wait", "epoll_ctl", "recv", "recv_eagain", "send", "send_eagain", "sendfile", "eventfd", "accept"};
+
+// 系统调用计数快照（累计值）
+struct SyscallStats{
+    uint64_t calls[sys_kinds]; // 各类调用次数
+    uint64_t requests;         // 处理的请求数（由消息回调经CountRequests登记）
+
+    // 系统调用总数（EAGAIN两项是recv/send的子集，不重复计入）
+    uint64_t Total() const
+    {
+        uint64_t total = 0;
+        for(int k = 0; k < sys_kinds; ++k)
+            if(k != sys_recv_eagain && k != sys_send_eagain) total += calls[k];
+        return total;
+    }
+
+    // 平均每个请求的调用次数，kind为sys_kinds时为总数
+    double PerRequest(int kind = sys_kinds) const
+    {
+        if(requests == 0) return 0;
+        return (double)(kind == sys_kinds ? Total() : calls[kind]) / requests;
+    }
+
+    // 两次快照之差
+    SyscallStats operator-(const SyscallStats &other) const
+    {
+        SyscallStats diff;
+        for(int k = 0; k < sys_kinds; ++k) diff.calls[k] = calls[k] - other.calls[k];
+        diff.requests = requests - other.requests;
+        return diff;
+    }
+
+    // 每请求的各类调用次数，如"requests=1000 total=1.02 epoll_wait=0.51 ..."
+    std::string ToString() const
+    {
+        std::string out;
+        char item[64];
+        snprintf(item, sizeof(item), "requests=%lu total=%.2f", requests, PerRequest());
+        out += item;
+        for(int k = 0; k < sys_kinds; ++k)
+        {
+            snprintf(item, sizeof(item), " %s=%.2f", syscall_names[k], PerRequest(k));
+            out += item;
+        }
+        return out;
+    }
+};
 
 // 客户端信息结构体
 struct ClientInf{
     int sockfd;             // 客户端socket文件描述符
-    std::string client_ip;  // 客户端IP地址
+    uint32_t client_ip;     // 客户端IPv4地址（网络字节序，按需格式化）
     uint16_t client_port;   // 客户端端口号
+    sa_family_t family;     // 地址族：AF_INET或AF_UNIX
+    bool shm = false;       // 在该Unix域连接上握手后改走共享内存传输
+};
+
+// 迁移中的连接：已从源事件循环摘除，连同空闲定时器状态交给目标事件循环
+struct ConnectionHandoff{
+    std::shared_ptr<Connection> connection; // 连接对象（缓冲区暂用默认分配器）
+    int expired_time;       // 空闲定时器的过期时间
+    int alive_cnt;          // 空闲定时器的活跃计数
 };
 
 // 事件循环类，继承enable_shared_from_this以支持shared_from_this()
@@ -49,119 +159,485 @@ public:
     OnMessage_(OnMessage),       // 设置消息回调
     TaskPush_(TaskPush),         // 设置任务推送函数
     rq_(rq),                     // 设置环形队列
-    tm_(new TimerManager())      // 初始化定时器管理器
-    {}
+    tm_(new TimerManager()),     // 初始化定时器管理器
+    pool_(new BufferPool()),     // 连接缓冲池
+    recvs_(min_event_batch),     // 事件数组按负载自适应伸缩
+    low_rounds_(0),
+    iterations_(0),
+    spin_idle_ns_(0),
+    last_active_ns_(0),
+    quit_(false)
+    {
+        // 唤醒用eventfd：其他线程可借此打断epoll_wait
+        wakeup_fd_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        Ctl(EPOLL_CTL_ADD, wakeup_fd_, EPOLLIN | EPOLLET);
+
+        // 工作线程监听任务队列的入队通知；EPOLLEXCLUSIVE使每次入队只唤醒一个空闲线程
+        if(rq_ && TaskPush_ && rq_->NotifyFd() >= 0)
+            Ctl(EPOLL_CTL_ADD, rq_->NotifyFd(), EPOLLIN | EPOLLEXCLUSIVE);
+    }
+
+    ~EventLoop()
+    {
+        close(wakeup_fd_);
+    }
     
-    // 添加新连接到事件循环
-    void AddConnection(int sock,           // socket文件描述符
+    // 添加新连接到事件循环，返回新建的连接对象
+    std::shared_ptr<Connection> AddConnection(int sock,           // socket文件描述符
                       uint32_t event,      // 监听的事件类型
                       func_t recv_cb,     // 读回调
                       func_t send_cb,      // 写回调
                       func_t except_cb,   // 异常回调
-                      const std::string &ip = "0.0.0.0",  // IP地址
+                      uint32_t ip = INADDR_ANY,  // IPv4地址（网络字节序）
                       uint16_t port = 0,   // 端口号
                       bool is_listensock = false)  // 是否监听socket
     {
         // 创建新连接对象
-        std::shared_ptr<Connection> new_connect(new Connection(sock));
+        std::shared_ptr<Connection> new_connect(new Connection(sock, pool_));
         new_connect->el = shared_from_this();  // 设置所属事件循环
         new_connect->recv_cb = recv_cb;       // 设置读回调
         new_connect->send_cb = send_cb;        // 设置写回调
         new_connect->except_cb = except_cb;    // 设置异常回调
-        new_connect->ip_ = ip;                 // 设置IP
+        new_connect->addr_ = ip;               // 设置IP
         new_connect->port_ = port;             // 设置端口
 
         // 如果不是监听socket，则加入定时器管理
         if(!is_listensock) tm_->Push(new_connect);
+        if(capture_ && !is_listensock) new_connect->capture_id_ = capture_->Connect();
         // 添加到连接映射表
         connections_[sock] = new_connect;
 
         // 将socket添加到epoll监听
-        epoller_->EpollCtl(EPOLL_CTL_ADD, sock, event);
+        Ctl(EPOLL_CTL_ADD, sock, event);
+        return new_connect;
+    }
+
+    /**
+     * @brief 在已accept的Unix域socket上完成共享内存握手并接入连接（握手后关闭sock）
+     * @note 连接以本端通知eventfd注册，读写回调与socket连接相同，Recv/Send按通道收发，
+     *       OnMessage等处理逻辑不变；握手失败时返回空
+     */
+    std::shared_ptr<Connection> AddShmConnection(int sock, size_t ring_bytes = default_shm_ring_bytes)
+    {
+        auto channel = ShmChannel::Accept(sock, ring_bytes);
+        close(sock);
+        if(!channel) return nullptr;
+        auto self = shared_from_this();
+        auto connection = AddConnection(channel->NotifyFd(), EPOLLIN | EPOLLET,
+                                        std::bind(&EventLoop::Recv, self, std::placeholders::_1),
+                                        std::bind(&EventLoop::Send, self, std::placeholders::_1),
+                                        std::bind(&EventLoop::Except, self, std::placeholders::_1));
+        connection->family_ = AF_UNIX;
+        connection->shm_ = channel;
+        lg(Info, "client [shm: %d] attached, ring bytes: %lu", connection->Sockfd(), ring_bytes);
+        return connection;
+    }
+
+    // 修改已注册fd监听的事件；events为0时暂停该fd（仍保留在连接表中）
+    void UpdateEvents(int sock, uint32_t events)
+    {
+        Ctl(EPOLL_CTL_MOD, sock, events);
+    }
+
+    // 从事件循环中摘除连接但不关闭socket，fd交由调用者处理（如连接建立后转交他人）
+    std::shared_ptr<Connection> RemoveConnection(int sock)
+    {
+        auto iter = connections_.find(sock);
+        if(iter == connections_.end()) return nullptr;
+        auto connection = iter->second;
+        Ctl(EPOLL_CTL_DEL, sock, 0);
+        connections_.erase(iter);
+        tm_->LazyDelete(sock);
+        if(capture_ && connection->capture_id_) capture_->Close(connection->capture_id_);
+        return connection;
     }
     
+    /**
+     * @brief 把连接迁往target（只能在本线程、连接回调之外调用）
+     * @note 先从本循环的epoll和连接表摘除，再排入target的任务队列由其线程接管；
+     *       期间到达的数据留在内核接收缓冲区，target注册时边缘触发会立即报告可读，
+     *       已读入输入缓冲区的数据与未发完的输出随连接一起转移，字节不丢失也不乱序。
+     *       连接须以本类的Recv/Send/Except为回调（target接管时改绑为自身的对应函数）；
+     *       监听socket、协程处理的连接以及有待发文件区间的连接（管道可能正注册在本循环的epoll中）
+     *       不能迁移，返回false
+     */
+    bool MigrateConnection(int sock, std::shared_ptr<EventLoop> target)
+    {
+        if(target.get() == this) return false;
+        auto iter = connections_.find(sock);
+        if(iter == connections_.end() || iter->second->co_started_ || iter->second->HasFile()) return false;
+        ConnectionHandoff handoff{iter->second, 0, 0};
+        if(!tm_->Take(sock, handoff.expired_time, handoff.alive_cnt)) return false;  // 监听socket不受定时器管理
+
+        Ctl(EPOLL_CTL_DEL, sock, 0);
+        connections_.erase(iter);
+        handoff.connection->ReleaseIdleBuffers();
+        handoff.connection->Rehome(nullptr);  // 缓冲区内存在本线程归还本循环的缓冲池
+        Count(stats_.migrated_out, 1);
+        TraceInstant("migrate_out", "fd", sock);
+        target->QueueInLoop([target, handoff]() { target->Adopt(handoff); });
+        return true;
+    }
+
+    /**
+     * @brief 接管其他事件循环迁出的连接（本线程调用，一般经MigrateConnection排入）
+     * @note 缓冲区改用本循环的缓冲池，读写回调改绑本循环，保留原有的空闲定时器状态
+     */
+    void Adopt(ConnectionHandoff handoff)
+    {
+        auto &connection = handoff.connection;
+        int sock = connection->Sockfd();
+        connection->Rehome(pool_);
+        auto self = shared_from_this();
+        connection->el = self;
+        connection->recv_cb = std::bind(&EventLoop::Recv, self, std::placeholders::_1);
+        connection->send_cb = std::bind(&EventLoop::Send, self, std::placeholders::_1);
+        connection->except_cb = std::bind(&EventLoop::Except, self, std::placeholders::_1);
+        tm_->Push(connection, handoff.expired_time, handoff.alive_cnt);
+        connections_[sock] = connection;
+        // 未发完的输出继续关注写事件，注册时已就绪的读写事件会立即报告
+        uint32_t events = EPOLLIN | EPOLLET;
+        if(!connection->shm_)
+        {
+            if(persistent_out_)
+            {
+                events = ConnEvents();
+                connection->write_care_ = false;
+                connection->writable_ = true;
+            }
+            else if(connection->write_care_)
+            {
+                events |= EPOLLOUT;
+            }
+        }
+        Ctl(EPOLL_CTL_ADD, sock, events);
+        Count(stats_.migrated_in, 1);
+        TraceInstant("migrate_in", "fd", sock);
+    }
+
+    /**
+     * @brief 把本循环约share比例的流量迁往target（本线程调用）
+     * @note 按本统计周期各连接收到的字节数从大到小挑选，跳过单个就超出剩余份额的连接
+     *       （整体搬走一个热点连接只会把不均衡转移到target）；结束后开始新的统计周期
+     * @return 迁出的连接数
+     */
+    size_t MigrateTo(std::shared_ptr<EventLoop> target, double share)
+    {
+        std::vector<std::pair<uint64_t, int>> candidates;
+        uint64_t total = 0;
+        for(auto &[sock, connection] : connections_)
+        {
+            total += connection->rx_bytes_;
+            if(connection->rx_bytes_) candidates.emplace_back(connection->rx_bytes_, sock);
+        }
+        std::sort(candidates.begin(), candidates.end(), std::greater<>());
+        uint64_t budget = (uint64_t)(total * share);
+        size_t moved = 0;
+        for(auto &[bytes, sock] : candidates)
+        {
+            if(moved >= max_migrate_batch || budget == 0) break;
+            if(bytes > budget) continue;
+            if(!MigrateConnection(sock, target)) continue;
+            budget -= bytes;
+            ++moved;
+        }
+        ResetTraffic();
+        if(moved) lg(Info, "migrated %lu connections to another loop, share %.2f", moved, share);
+        return moved;
+    }
+
+    // 开始新的流量统计周期（本线程调用）
+    void ResetTraffic()
+    {
+        for(auto &[sock, connection] : connections_) connection->rx_bytes_ = 0;
+    }
+
     // 从连接接收数据
     void Recv(std::weak_ptr<Connection> connect)
     {
         auto connection = connect.lock();  // 获取连接的共享指针
+        if(connection->shm_)
+        {
+            ShmRecv(connection);
+            return;
+        }
         int sock = connection->Sockfd();   // 获取socket文件描述符
+        // 常驻模式下TCP连接读到不满缓冲区即已读空：之后到达的数据会产生新的边缘事件，
+        // 对端关闭由EPOLLRDHUP报告，此时才需读到0，省去结尾那次返回EAGAIN的recv
+        bool drain = !persistent_out_ || connection->family_ != AF_INET || connection->rdhup_;
+        // 用recvmsg取回msg_flags：seqpacket消息超过接收缓冲区时余下部分被内核丢弃，只能由MSG_TRUNC得知
+        struct iovec iov = {buffer, sizeof(buffer) - 1};
+        struct msghdr msg;
+        memset(&msg, 0, sizeof(msg));
+        msg.msg_iov = &iov;
+        msg.msg_iovlen = 1;
         
         while(true)
         {
             // 接收数据
-            ssize_t n = recv(sock, buffer, sizeof(buffer) - 1, 0);
+            ssize_t n = recvmsg(sock, &msg, 0);
+            Count(syscalls_[sys_recv], 1);
+            if(n > 0 && (msg.msg_flags & MSG_TRUNC))  // 消息不完整，无法再确定帧边界
+            {
+                lg(Warning, "client [%s: %d] message exceeds %lu bytes, closed",
+                   connection->Ip(), connection->port_, sizeof(buffer) - 1);
+                connection->except_cb(connection);
+                return;
+            }
             if(n > 0)  // 成功接收到数据
             {
                 buffer[n] = 0;  // 添加字符串结束符
-                connection->AppendInBuffer(buffer);  // 将数据追加到输入缓冲区
+                connection->AppendInBuffer(std::string_view(buffer, n));  // 将数据追加到输入缓冲区
+                connection->rx_bytes_ += n;
+                if(capture_ && connection->capture_id_) capture_->Data(connection->capture_id_, buffer, n);
                 lg(Debug, "thread-%d, recv message from client: %s", pthread_self(),buffer);
+                if(!drain && (size_t)n < sizeof(buffer) - 1) break;
             }
             else if(n == 0)  // 客户端关闭连接
             {
-                lg(Info, "client [%s: %d] quit", connection->ip_.c_str(), connection->port_);
+                lg(Info, "client [%s: %d] quit", connection->Ip(), connection->port_);
                 connection->except_cb(connection);  // 调用异常回调
                 return;
             }
             else  // 接收出错
             {
-                if(errno == EWOULDBLOCK) break;  // 非阻塞模式下无数据可读
+                if(errno == EWOULDBLOCK)  // 非阻塞模式下无数据可读
+                {
+                    Count(syscalls_[sys_recv_eagain], 1);
+                    break;
+                }
                 else if(errno == EINTR) continue;  // 被信号中断，继续读取
                 else  // 其他错误
                 {
-                    lg(Error, "recv from client [%s: %d] false", connection->ip_.c_str(), connection->port_);
+                    lg(Error, "recv from client [%s: %d] false", connection->Ip(), connection->port_);
                     connection->except_cb(connection);
                     return;
                 }
             }
         }
         
-        // 如果有消息处理回调，则调用
-        if(OnMessage_)
+        // 如果有消息处理回调，则调用；等待发送后关闭的连接丢弃后续输入
+        if(connection->close_after_send_)
+            connection->Inbuffer().clear();
+        else if(OnMessage_)
             OnMessage_(connection);
     }
     
     // 向连接发送数据
+    // 先发送内存缓冲区，清空后再依次零拷贝发送排队的文件区间
     void Send(std::weak_ptr<Connection> connect)
     {
         auto connection = connect.lock();  // 获取连接的共享指针
-        std::string &outbuffer = connection->OutBuffer();  // 获取输出缓冲区
+        if(connection->shm_)
+        {
+            ShmSend(connection);
+            return;
+        }
+        // 常驻模式下上次发送已遇到EAGAIN：等待EPOLLOUT，不再做注定失败的send
+        if(persistent_out_ && !connection->writable_) return;
+        buffer_t &outbuffer = connection->OutBuffer();  // 获取输出缓冲区
         
         while(true)
         {
+            if(outbuffer.empty())
+            {
+                if(!connection->HasFile()) break;  // 全部发送完成
+                int ret = SendFile(connection);
+                if(ret > 0) continue;   // 当前文件发送完毕，继续发送其后的数据
+                if(ret == 0) break;     // 发送缓冲区满
+                connection->except_cb(connection);
+                return;
+            }
+
             // 发送数据
             ssize_t n = send(connection->Sockfd(), outbuffer.c_str(), outbuffer.size(), 0);
+            Count(syscalls_[sys_send], 1);
             if(n > 0)  // 成功发送部分数据
             {
                 outbuffer.erase(0, n);  // 从缓冲区移除已发送数据
-                if(outbuffer.empty()) break;  // 缓冲区已空，发送完成
             }
             else if(n == 0) return;  // 发送0字节，连接可能已关闭
             else  // 发送出错
             {
-                if(errno == EWOULDBLOCK) break;  // 发送缓冲区满
+                if(errno == EWOULDBLOCK)  // 发送缓冲区满
+                {
+                    Count(syscalls_[sys_send_eagain], 1);
+                    connection->writable_ = false;
+                    break;
+                }
                 else if(errno == EINTR) continue;  // 被信号中断，继续发送
                 else  // 其他错误
                 {
-                    lg(Error, "send to client [%s: %d] false", connection->ip_.c_str(), connection->port_);
+                    lg(Error, "send to client [%s: %d] false", connection->Ip(), connection->port_);
                     connection->except_cb(connection);
                     return;
                 }
             }
-            
-            // 根据缓冲区状态调整epoll监听事件
-            if(!outbuffer.empty() && !connection->write_care_)  // 缓冲区非空且未关注写事件
+        }
+
+        // 根据缓冲区状态调整epoll监听事件（常驻模式下写事件一直注册，无需调整）
+        bool pending = !connection->OutEmpty();
+        if(!pending && connection->close_after_send_)  // 最后的响应已发出
+        {
+            connection->except_cb(connection);
+            return;
+        }
+        if(pending && !connection->write_care_ && !persistent_out_)  // 仍有数据未发且未关注写事件
+        {
+            // 添加对写事件的监听（边缘触发模式），可写时继续发送
+            Ctl(EPOLL_CTL_MOD, connection->Sockfd(), EPOLLIN | EPOLLOUT | EPOLLET);
+            connection->write_care_ = true;
+        }
+        else if(!pending && connection->write_care_)  // 已全部发送且关注了写事件
+        {
+            // 取消对写事件的监听
+            Ctl(EPOLL_CTL_MOD, connection->Sockfd(), EPOLLIN | EPOLLET);
+            connection->write_care_ = false;
+        }
+
+        // 输出全部发送后唤醒等待写完成的协程
+        if(!pending && connection->write_waiter_)
+            std::exchange(connection->write_waiter_, nullptr).resume();
+    }
+
+    /**
+     * @brief 共享内存连接的读事件：取出请求环中的全部数据后交给OnMessage
+     * @note 通知eventfd的计数不读取清零：每次写入都会产生新的边缘事件，省去一次read；
+     *       对端腾出响应环空间时同样经此唤醒，先续发积压的响应
+     */
+    void ShmRecv(std::shared_ptr<Connection> &connection)
+    {
+        ShmChannel *channel = connection->shm_.get();
+        buffer_t &inbuffer = connection->Inbuffer();
+        size_t before = inbuffer.size();
+        uint64_t notifies = channel->Notifies();
+        size_t n = channel->Recv(inbuffer);
+        Count(syscalls_[sys_eventfd], channel->Notifies() - notifies);
+        if(n)
+        {
+            connection->rx_bytes_ += n;
+            if(capture_ && connection->capture_id_) capture_->Data(connection->capture_id_, inbuffer.data() + before, n);
+        }
+        if(channel->Corrupt())
+        {
+            lg(Warning, "client [shm: %d] corrupted shared ring, closed", connection->Sockfd());
+            connection->except_cb(connection);
+            return;
+        }
+        if(!connection->OutEmpty()) ShmSend(connection);
+        if(connection->closed_) return;  // 续发完最后的响应后已关闭
+        if(n && OnMessage_ && !connection->close_after_send_) OnMessage_(connection);
+        // 对端关闭前写入的请求已处理完
+        if(!connection->closed_ && channel->PeerClosed())
+        {
+            lg(Info, "client [shm: %d] quit", connection->Sockfd());
+            connection->except_cb(connection);
+        }
+    }
+
+    // 共享内存连接的发送：写入响应环，环满时剩余数据留在输出缓冲区，待对端取走后续发
+    void ShmSend(std::shared_ptr<Connection> &connection)
+    {
+        if(connection->HasFile())
+        {
+            lg(Warning, "client [shm: %d] does not support file regions, dropped", connection->Sockfd());
+            connection->ClearFiles();
+        }
+        buffer_t &outbuffer = connection->OutBuffer();
+        uint64_t notifies = connection->shm_->Notifies();
+        size_t n = connection->shm_->Send(outbuffer.data(), outbuffer.size());
+        Count(syscalls_[sys_eventfd], connection->shm_->Notifies() - notifies);
+        if(connection->shm_->Corrupt())
+        {
+            lg(Warning, "client [shm: %d] corrupted shared ring, closed", connection->Sockfd());
+            connection->except_cb(connection);
+            return;
+        }
+        outbuffer.erase(0, n);
+        if(outbuffer.empty() && connection->close_after_send_)
+        {
+            connection->except_cb(connection);
+            return;
+        }
+        if(outbuffer.empty() && connection->write_waiter_)
+            std::exchange(connection->write_waiter_, nullptr).resume();
+    }
+
+    /**
+     * @brief 零拷贝发送队首文件区间
+     * @return 1 文件已发送完毕；0 发送缓冲区满需等待EPOLLOUT，或管道为空需等待管道可读；-1 出错
+     */
+    int SendFile(std::shared_ptr<Connection> &connection)
+    {
+        FileRegion &region = connection->FrontFile();
+        int sock = connection->Sockfd();
+        while(region.length > 0)
+        {
+            ssize_t n;
+            if(region.is_pipe)
+                n = splice(region.fd, nullptr, sock, nullptr, region.length,
+                           SPLICE_F_MOVE | SPLICE_F_NONBLOCK);
+            else
+                n = sendfile(sock, region.fd, &region.offset, region.length);
+            Count(syscalls_[sys_sendfile], 1);
+
+            if(n > 0)
             {
-                // 添加对写事件的监听（边缘触发模式）
-                epoller_->EpollCtl(EPOLL_CTL_MOD,connection->Sockfd(), EPOLLIN | EPOLLOUT | EPOLLET);
-                connection->write_care_ = true;
+                region.length -= n;
             }
-            else if(outbuffer.empty() && connection->write_care_)  // 缓冲区空且关注了写事件
+            else if(n == 0)
             {
-                // 取消对写事件的监听
-                epoller_->EpollCtl(EPOLL_CTL_MOD,connection->Sockfd(), EPOLLIN | EPOLLET);
-                connection->write_care_ = false;
+                // 文件提前结束（被截断或管道写端关闭），丢弃剩余长度
+                lg(Warning, "file fd %d ended with %lu bytes unsent", region.fd, region.length);
+                break;
+            }
+            else
+            {
+                if(errno == EWOULDBLOCK)
+                {
+                    // splice的EAGAIN也可能是管道暂时为空：此时socket仍可写，改为等待管道可读
+                    if(region.is_pipe && PipeEmpty(region.fd))
+                    {
+                        if(!region.pipe_wait)
+                        {
+                            region.pipe_wait = true;
+                            pipe_waiters_[region.fd] = connection;
+                            Ctl(EPOLL_CTL_ADD, region.fd, EPOLLIN);
+                        }
+                        return 0;
+                    }
+                    connection->writable_ = false;
+                    return 0;
+                }
+                else if(errno == EINTR) continue;
+                lg(Error, "sendfile to client [%s: %d] false, errno: %d, errstr: %s",
+                   connection->Ip(), connection->port_, errno, strerror(errno));
+                return -1;
             }
         }
+        connection->PopFile();
+        return 1;
+    }
+
+    // 管道中没有数据且写端未关闭（POLLHUP时splice会返回0）
+    bool PipeEmpty(int fd)
+    {
+        struct pollfd pfd = {fd, POLLIN, 0};
+        return poll(&pfd, 1, 0) == 0;
+    }
+
+    // 等待中的管道可读：撤销注册并续发该连接；不是等待中的管道返回false
+    bool ResumePipe(int fd)
+    {
+        auto iter = pipe_waiters_.find(fd);
+        if(iter == pipe_waiters_.end()) return false;
+        auto connection = iter->second.lock();
+        pipe_waiters_.erase(iter);
+        Ctl(EPOLL_CTL_DEL, fd, 0);
+        if(!connection || !connection->HasFile()) return true;
+        connection->FrontFile().pipe_wait = false;
+        if(connection->send_cb) connection->send_cb(connection);
+        return true;
     }
     
     // 处理连接异常
@@ -170,70 +646,453 @@ public:
         auto connection = connect.lock();  // 获取连接的共享指针
         int fd = connection->Sockfd();     // 获取socket文件描述符
         
-        lg(Warning, "client [%s: %d] handler exception", connection->ip_.c_str(), connection->port_);
+        lg(Warning, "client [%s: %d] handler exception", connection->Ip(), connection->port_);
 
         // 从epoll中删除该socket
-        epoller_->EpollCtl(EPOLL_CTL_DEL, fd, 0);
-        lg(Debug, "client [%s: %d] close done", connection->ip_.c_str(), connection->port_);
+        Ctl(EPOLL_CTL_DEL, fd, 0);
+        lg(Debug, "client [%s: %d] close done", connection->Ip(), connection->port_);
         
-        close(fd);  // 关闭socket
+        if(connection->shm_) connection->shm_->Close();  // 通知对端、解除映射并关闭通知fd
+        else close(fd);  // 关闭socket
+        if(connection->HasFile() && connection->FrontFile().pipe_wait)
+        {
+            int pipe_fd = connection->FrontFile().fd;
+            pipe_waiters_.erase(pipe_fd);
+            Ctl(EPOLL_CTL_DEL, pipe_fd, 0);  // fd可能不归连接所有，关闭前先撤销注册
+        }
+        connection->ClearFiles();  // 释放未发送的文件区间
         connections_.erase(fd);  // 从连接表中移除
         tm_->LazyDelete(fd);     // 从定时器中延迟删除
+        if(capture_ && connection->capture_id_) capture_->Close(connection->capture_id_);
+        if(admission_ && connection->family_ == AF_INET)
+            admission_->ReleaseConnection(connection->addr_);  // 归还来源IP的连接计数
+        connection->CancelWaiters(); // 唤醒挂起在该连接上的协程
     }
     
-    // 事件分发器
-    void DisPatcher()
+    // 事件分发器，返回本轮就绪事件数量
+    int DisPatcher()
     {
-        // 等待事件发生，返回就绪事件数量
-        int n = epoller_->EpollWait(recvs, max_fd);
+        // 上一轮（分发、协程恢复、超时处理）的请求级临时对象整体释放
+        arena_.Reset();
+        current_arena_ = &arena_;  // 回调中可通过CurrentArena()取得本线程竞技场
+        // 忙轮询模式下最近有过事件则零超时轮询，空闲超过阈值后退回阻塞等待
+        int64_t start = NowNs();
+        bool spin = spin_idle_ns_ > 0 && start - last_active_ns_ < spin_idle_ns_;
+        int timeout = spin ? 0 : NextTimeout();
+        int n;
+        {
+            TraceScope trace("epoll_wait", "timeout", timeout);
+            n = epoller_->EpollWait(recvs_.data(), recvs_.size(), timeout);
+            trace.Arg1("events", n);
+        }
+        Count(syscalls_[sys_epoll_wait], 1);
+        int64_t end = NowNs();
+        if(spin)
+        {
+            Count(stats_.spin_polls, 1);
+            Count(stats_.spin_ns, end - start);
+            if(n <= 0) Count(stats_.empty_polls, 1);
+        }
+        else
+        {
+            Count(stats_.blocking_waits, 1);
+            Count(stats_.wait_ns, end - start);
+        }
+        if(n > 0) last_active_ns_ = end;
+        else if(n == 0 && !spin) TrimBuffers();  // 阻塞等待超时：整轮空闲，归还缓存的缓冲区
+        poll_ns_ = end - start;
+        dispatching_ = true;
         for(int i = 0; i < n; ++i)
         {
-            uint32_t events = recvs[i].events;  // 事件类型
-            int sockfd = recvs[i].data.fd;      // 发生事件的socket
+            uint32_t events = recvs_[i].events;  // 事件类型
+            int sockfd = recvs_[i].data.fd;      // 发生事件的socket
+            if(sockfd == wakeup_fd_)
+            {
+                uint64_t cnt;
+                while(read(wakeup_fd_, &cnt, sizeof(cnt)) > 0) Count(syscalls_[sys_eventfd], 1);  // 清空计数
+                Count(syscalls_[sys_eventfd], 1);
+                continue;
+            }
+            if(!pipe_waiters_.empty() && ResumePipe(sockfd)) continue;
+            if(rq_ && sockfd == rq_->NotifyFd())
+            {
+                // 取走一个入队计数，本轮结束后由TaskPush接管新连接；
+                // 计数未取完时（水平触发）会继续唤醒本线程或其他空闲线程
+                uint64_t cnt;
+                read(sockfd, &cnt, sizeof(cnt));
+                Count(syscalls_[sys_eventfd], 1);
+                continue;
+            }
             
             // 将错误事件转换为读写事件处理
             if(events & (EPOLLERR | EPOLLHUP)) events |= (EPOLLIN | EPOLLOUT);
 
+            auto iter = connections_.find(sockfd);
+            if(iter == connections_.end()) continue;
+            // 持有一份引用，回调中连接被移除时对象仍然有效
+            auto connection = iter->second;
+            TraceScope trace("dispatch", "fd", sockfd, "events", events);
+            if(events & EPOLLRDHUP) connection->rdhup_ = true;
+
             // 处理读事件
-            if(events & EPOLLIN && connections_[sockfd]->recv_cb) 
+            if(events & EPOLLIN && connection->recv_cb) 
             {
-                connections_[sockfd]->recv_cb(connections_[sockfd]);
+                connection->recv_cb(connection);
                 tm_->UpdateTime(sockfd);  // 更新该连接的定时器
             }
-            // 处理写事件
-            if(events & EPOLLOUT && connections_[sockfd]->send_cb) 
+            // 读回调中连接可能已被关闭
+            if(connections_.find(sockfd) == connections_.end()) continue;
+            // 处理写事件；常驻模式下每次读事件都带有EPOLLOUT，只在有待发数据时发送
+            if(events & EPOLLOUT) connection->writable_ = true;
+            if(events & EPOLLOUT && connection->send_cb && (!persistent_out_ || !connection->OutEmpty()))
             {
-                connections_[sockfd]->send_cb(connections_[sockfd]);
+                connection->send_cb(connection);
                 tm_->UpdateTime(sockfd);  // 更新该连接的定时器
             }
+            connection->ReleaseIdleBuffers();  // 已处理完的缓冲区归还缓冲池
         }
+        dispatching_ = false;
+        AdjustBatch(n);
+        return n;
     }
     
     // 检查过期连接
     void Expired_check()
     {
+        TraceScope trace("expire_check", "expired", 0);
+        int expired = 0;
         while(tm_->IsTopExpired())  // 检查堆顶定时器是否过期
         {
+            ++expired;
             auto top_time = tm_->GetTop()->connect;  // 获取过期连接
             int sockfd = top_time->Sockfd();         // 获取socket文件描述符
             
             // 如果连接仍然存在（未被客户端主动关闭）
             if(connections_.find(sockfd) != connections_.end())
                 connections_[sockfd]->except_cb(top_time);  // 调用异常回调处理
+            else
+                tm_->LazyDelete(sockfd);  // 防止残留定时器使循环无法结束
         }
+        if(expired) trace.Arg0(expired);
+        else trace.Cancel();  // 没有过期连接时不记录
+    }
+    
+    // 执行所有到期的定时器（含休眠协程的恢复）
+    void RunTimed()
+    {
+        TraceScope trace("timers", "fired", 0);
+        size_t fired = timers_.RunExpired(NowMs());
+        if(fired) trace.Arg0(fired);
+        else trace.Cancel();
+    }
+
+    /**
+     * 定时器：回调在本线程执行，只能在本线程调用（其他线程经RunInLoop转入）
+     * RunAt: 在when（steady时钟毫秒，见NowMs）时刻执行一次
+     * RunAfter: delay_ms毫秒后执行一次
+     * RunEvery: 每隔interval_ms毫秒执行一次，首次在一个周期之后
+     * 返回的ID可用于Cancel；单次定时器执行后ID失效
+     */
+    timer_id_t RunAt(int64_t when, std::function<void()> cb)
+    {
+        return timers_.Add(when, 0, std::move(cb));
+    }
+
+    timer_id_t RunAfter(int64_t delay_ms, std::function<void()> cb)
+    {
+        return timers_.Add(NowMs() + delay_ms, 0, std::move(cb));
+    }
+
+    timer_id_t RunEvery(int64_t interval_ms, std::function<void()> cb)
+    {
+        if(interval_ms <= 0) interval_ms = 1;
+        return timers_.Add(NowMs() + interval_ms, interval_ms, std::move(cb));
+    }
+
+    // 取消定时器，定时器仍在等待时返回true；可在回调中取消周期定时器自身
+    bool Cancel(timer_id_t id)
+    {
+        return timers_.Cancel(id);
+    }
+
+    /// 等待中的定时器数量
+    size_t PendingTimers() { return timers_.Size(); }
+
+    // 协程休眠：co_await loop->Sleep(ms)（定义见coroutine.hpp）
+    SleepAwaiter Sleep(int ms);
+
+    // 登记一个在when（steady时钟毫秒）时刻于本线程恢复的协程
+    void ResumeAt(int64_t when, std::coroutine_handle<> handle)
+    {
+        timers_.Add(when, 0, [handle]() { handle.resume(); });  // 协程可能再次休眠并登记新的定时器
+    }
+
+    // 当前steady时钟毫秒数
+    static int64_t NowMs()
+    {
+        return std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    // 当前steady时钟纳秒数
+    static int64_t NowNs()
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+    
+    // 唤醒阻塞在epoll_wait中的事件循环（线程安全）
+    void Wakeup()
+    {
+        uint64_t one = 1;
+        write(wakeup_fd_, &one, sizeof(one));
+    }
+
+    // 在事件循环线程中执行fn（线程安全）：本线程调用时立即执行，否则排队并唤醒
+    void RunInLoop(std::function<void()> fn)
+    {
+        if(InLoopThread()) fn();
+        else QueueInLoop(std::move(fn));
+    }
+
+    // 将fn排入队列，在本轮事件分发之后执行（线程安全）
+    // 同一轮内多次排队只唤醒一次；只有本线程在DisPatcher分发事件期间排队无需唤醒（随后即RunPending），
+    // 在RunPending、定时器、超时检查、TaskPush中排队都要唤醒，否则要等到下一个事件或超时
+    void QueueInLoop(std::function<void()> fn)
+    {
+        bool wake;
+        {
+            std::lock_guard<std::mutex> lock(pending_mtx_);
+            wake = pending_.empty();
+            pending_.push_back(std::move(fn));
+        }
+        if(wake && (!InLoopThread() || !dispatching_)) Wakeup();
+    }
+
+    // 执行排队的函数；执行期间新排入的留到下一轮
+    void RunPending()
+    {
+        {
+            std::lock_guard<std::mutex> lock(pending_mtx_);
+            if(pending_.empty()) return;
+            running_.swap(pending_);
+        }
+        TraceScope trace("run_pending", "tasks", running_.size());
+        for(auto &fn : running_) fn();
+        running_.clear();
+    }
+
+    // 当前线程是否为运行Loop的线程
+    bool InLoopThread()
+    {
+        return thread_id_.load(std::memory_order_relaxed) == std::this_thread::get_id();
+    }
+
+    // 请求事件循环在本轮结束后退出（线程安全）
+    void Stop()
+    {
+        quit_ = true;
+        Wakeup();
     }
     
     // 主事件循环
     void Loop()
     {
-        while(true)
+        thread_id_.store(std::this_thread::get_id(), std::memory_order_relaxed);
+        while(!quit_)
         {
+            int64_t start = NowNs();
             // 如果有任务推送函数，则执行
             if(TaskPush_) TaskPush_(rq_, shared_from_this());
             
-            DisPatcher();      // 事件分发
+            int n = DisPatcher();  // 事件分发
+            RunPending();      // 执行其他线程投递的函数
+            RunTimed();        // 执行到期的定时器与休眠协程
             Expired_check();   // 检查过期连接
+            Count(iterations_, 1);
+
+            // 除epoll_wait外的耗时；忙轮询未取到事件的轮次整轮计为空转
+            int64_t rest = NowNs() - start - poll_ns_;
+            if(n <= 0 && spin_idle_ns_ > 0) Count(stats_.spin_ns, rest);
+            else Count(stats_.work_ns, rest);
+        }
+    }
+
+    /**
+     * 开启忙轮询模式（须在Loop之前调用）
+     * spin_idle_us: 连续无事件超过该时长（微秒）后退回阻塞等待，有事件到达后重新忙轮询
+     * kernel_busy_usecs: 大于0时同时开启epoll实例的内核忙轮询（Linux 6.9+）
+     */
+    void EnableBusyPoll(int spin_idle_us = default_spin_idle_us, uint32_t kernel_busy_usecs = 0)
+    {
+        spin_idle_ns_ = (int64_t)spin_idle_us * 1000;
+        last_active_ns_ = NowNs();
+        if(kernel_busy_usecs > 0)
+            epoller_->SetBusyPoll(kernel_busy_usecs, default_busy_poll_budget, true);
+    }
+
+    /**
+     * 本循环的请求级竞技场，每轮分发开始时整体回卷
+     * 用于std::pmr容器：std::pmr::string tmp(loop->Arena());
+     * 分配的内存只在当前一轮内有效，不能跨co_await保存或放入连接状态
+     */
+    LoopArena *Arena() { return &arena_; }
+
+    // 当前线程所在EventLoop的竞技场；不在事件循环线程中时为默认分配器
+    static std::pmr::memory_resource *CurrentArena()
+    {
+        return current_arena_ ? current_arena_ : std::pmr::get_default_resource();
+    }
+
+    /**
+     * 归还缓冲池中缓存的空闲块，并让malloc把空闲页交还操作系统
+     * 事件循环整轮空闲时自动调用，内存紧张时也可由本线程主动调用
+     * 返回归还的字节数
+     */
+    size_t TrimBuffers()
+    {
+        if(pool_->Stats().cached_bytes == 0) return 0;
+        size_t released = pool_->Trim();
+        malloc_trim(0);
+        return released;
+    }
+
+    /// 设置缓冲池缓存空闲块的字节上限，超出部分释放时直接归还
+    void SetBufferCacheLimit(size_t bytes) { pool_->SetMaxCached(bytes); }
+
+    /// 缓冲池统计（仅限本线程读取）
+    BufferPoolStats BufferStats() { return pool_->Stats(); }
+
+    /// 运行统计快照（可跨线程读取）
+    LoopStats Stats()
+    {
+        return {stats_.spin_polls.load(std::memory_order_relaxed),
+                stats_.empty_polls.load(std::memory_order_relaxed),
+                stats_.blocking_waits.load(std::memory_order_relaxed),
+                stats_.spin_ns.load(std::memory_order_relaxed),
+                stats_.wait_ns.load(std::memory_order_relaxed),
+                stats_.work_ns.load(std::memory_order_relaxed),
+                stats_.migrated_in.load(std::memory_order_relaxed),
+                stats_.migrated_out.load(std::memory_order_relaxed)};
+    }
+
+    /// 为预计的连接数预留连接表和定时器表容量（海量连接模式）
+    void Reserve(size_t n)
+    {
+        connections_.reserve(n);
+        tm_->Reserve(n);
+    }
+
+    /**
+     * 设置准入控制（与Listener共用同一实例）：连接关闭时归还来源IP的连接计数，
+     * 消息处理回调可通过Admission()做请求速率检查
+     */
+    void SetAdmission(std::shared_ptr<AdmissionControl> admission) { admission_ = admission; }
+
+    /// 准入控制，未设置时为空
+    AdmissionControl *Admission() { return admission_.get(); }
+
+    /**
+     * 开启流量录制（须在Loop之前于本线程调用）：此后接入的连接收到的字节流
+     * 连同时间戳写入writer，各工作线程共用同一个writer；缓冲的记录至少每秒写出一次
+     */
+    void SetCapture(std::shared_ptr<CaptureWriter> writer)
+    {
+        capture_.reset(new CaptureStream(writer));
+        RunEvery(capture_flush_ms, [this]() { capture_->Flush(); });
+    }
+
+    /**
+     * 开启写事件常驻模式（须在添加连接之前于本线程调用）：连接以ConnEvents()
+     * 即EPOLLIN|EPOLLOUT|EPOLLET|EPOLLRDHUP注册一次，不再随输出缓冲区状态用EPOLL_CTL_MOD
+     * 增删EPOLLOUT；可写状态在用户态跟踪，send遇到EAGAIN后等EPOLLOUT到达再发。
+     * TCP连接读到不满缓冲区即停止读取，对端关闭由EPOLLRDHUP报告
+     */
+    void EnablePersistentOut() { persistent_out_ = true; }
+
+    /// 新连接应注册的事件（随是否开启常驻模式而不同）
+    uint32_t ConnEvents()
+    {
+        return persistent_out_ ? (EPOLLIN | EPOLLOUT | EPOLLET | EPOLLRDHUP) : (EPOLLIN | EPOLLET);
+    }
+
+    /// 本循环执行的系统调用次数（由监听器等组件登记，只能在本线程调用）
+    void CountSyscall(SyscallKind kind, uint64_t n = 1) { Count(syscalls_[kind], n); }
+
+    /// 登记处理的请求数，用于计算每请求的系统调用次数（只能在本线程调用）
+    void CountRequests(uint64_t n) { Count(requests_, n); }
+
+    /// 系统调用计数快照（可跨线程读取）
+    SyscallStats Syscalls()
+    {
+        SyscallStats stats;
+        for(int k = 0; k < sys_kinds; ++k) stats.calls[k] = syscalls_[k].load(std::memory_order_relaxed);
+        stats.requests = requests_.load(std::memory_order_relaxed);
+        return stats;
+    }
+
+    /// 设置空闲连接超时时间（秒）
+    void SetIdleTimeout(int seconds)
+    {
+        tm_->SetGap(seconds);
+    }
+
+    /// 当前连接数（含监听socket）
+    size_t ConnectionCount() { return connections_.size(); }
+
+    /// 当前epoll_wait单批事件数
+    size_t EventBatch() { return recvs_.size(); }
+
+    /// 主循环已执行的轮数（可跨线程读取）
+    uint64_t Iterations() { return iterations_.load(std::memory_order_relaxed); }
+
+private:
+    // 仅由本线程写入的计数器，其他线程只读，无需原子读改写
+    static void Count(std::atomic<uint64_t> &counter, uint64_t v)
+    {
+        counter.store(counter.load(std::memory_order_relaxed) + v, std::memory_order_relaxed);
+    }
+
+    // epoll_ctl并计数
+    void Ctl(int op, int fd, uint32_t events)
+    {
+        Count(syscalls_[sys_epoll_ctl], 1);
+        epoller_->EpollCtl(op, fd, events);
+    }
+
+    // 根据本轮就绪事件数调整事件数组：填满则翻倍，长期低于1/8则减半
+    void AdjustBatch(int n)
+    {
+        size_t size = recvs_.size();
+        if((size_t)n == size && size < max_event_batch)
+        {
+            recvs_.resize(size * 2);
+            low_rounds_ = 0;
         }
+        else if((size_t)n < size / 8 && size > min_event_batch)
+        {
+            if(++low_rounds_ >= shrink_rounds)
+            {
+                recvs_.resize(size / 2);
+                recvs_.shrink_to_fit();
+                low_rounds_ = 0;
+            }
+        }
+        else
+        {
+            low_rounds_ = 0;
+        }
+    }
+
+    // 计算本轮epoll_wait超时：有定时器时不超过最近的到期时间
+    int NextTimeout()
+    {
+        int timeout = epoller_->Timeout();
+        int64_t when = timers_.NextWhen();
+        if(when < 0) return timeout;
+        int64_t wait = when - NowMs();
+        if(wait <= 0) return 0;
+        return wait < timeout ? (int)wait : timeout;
     }
 
 public:
@@ -241,11 +1100,43 @@ public:
 
 private:
     std::unordered_map<int, std::shared_ptr<Connection>> connections_;  // 连接表
+    std::unordered_map<int, std::weak_ptr<Connection>> pipe_waiters_;   // 等待管道可读的连接（按管道fd）
     std::shared_ptr<Epoll> epoller_;             // epoll实例
     std::shared_ptr<TimerManager> tm_;           // 定时器管理器
-    struct epoll_event recvs[max_fd];            // epoll事件数组
+    std::shared_ptr<BufferPool> pool_;           // 连接缓冲池，连接对象共同持有
+    std::shared_ptr<AdmissionControl> admission_; // 准入控制（可为空）
+    std::unique_ptr<CaptureStream> capture_;     // 流量录制（可为空）
+    std::vector<struct epoll_event> recvs_;      // epoll事件数组（自适应大小）
+    int low_rounds_;                             // 连续低负载轮数
+    std::atomic<uint64_t> iterations_;           // 主循环轮数
+    struct {
+        std::atomic<uint64_t> spin_polls{0};
+        std::atomic<uint64_t> empty_polls{0};
+        std::atomic<uint64_t> blocking_waits{0};
+        std::atomic<uint64_t> spin_ns{0};
+        std::atomic<uint64_t> wait_ns{0};
+        std::atomic<uint64_t> work_ns{0};
+        std::atomic<uint64_t> migrated_in{0};
+        std::atomic<uint64_t> migrated_out{0};
+    } stats_;                                    // 运行统计，字段含义见LoopStats
+    std::atomic<uint64_t> syscalls_[sys_kinds]{}; // 各类系统调用次数（仅本线程写入）
+    std::atomic<uint64_t> requests_{0};          // 处理的请求数
+    bool persistent_out_ = false;                // 写事件常驻模式
+    int64_t spin_idle_ns_;                       // 忙轮询退避阈值，0表示关闭忙轮询
+    int64_t last_active_ns_;                     // 最近一次取到事件的时间
+    int64_t poll_ns_ = 0;                        // 本轮epoll_wait耗时
+    LoopArena arena_;                            // 请求级临时对象竞技场
+    static inline thread_local LoopArena *current_arena_ = nullptr; // 本线程正在运行的竞技场
     func_t OnMessage_;                          // 消息到达回调
     task_t TaskPush_;                           // 任务推送函数
+    int wakeup_fd_;                             // 跨线程唤醒用eventfd
+    std::atomic<bool> quit_;                    // 退出标志
+    std::atomic<std::thread::id> thread_id_;    // 运行Loop的线程
+    std::mutex pending_mtx_;                    // 保护pending_
+    std::vector<std::function<void()>> pending_; // 其他线程投递、待在本线程执行的函数
+    std::vector<std::function<void()>> running_; // 正在执行的一批（与pending_交换以复用容量）
+    bool dispatching_ = false;                  // 是否正在DisPatcher中分发就绪事件
+    TimerQueue timers_;                         // 通用定时器（含休眠协程）
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,353 @@
+#ifndef _HTTP_HPP_
+#define _HTTP_HPP_ 1
+
+#include <string>
+#include <string_view>
+#include <cstring>
+#include <cstdio>
+#include <charconv>
+#include <ctime>
+
+inline const size_t http_max_header = 8 * 1024;   // 请求行加首部的最大长度
+inline const size_t http_max_body = 1024 * 1024;  // 请求体的最大长度
+
+// Next的返回值
+enum HttpParseStatus {
+    http_incomplete,  // 请求未收全
+    http_complete,    // 取出一个完整请求
+    http_error        // 格式错误或超出限制，连接应回复错误后关闭
+};
+
+/**
+ * @brief 解析出的HTTP请求
+ * @note 各字段指向输入缓冲区，在下一次Compact或缓冲区被修改前有效
+ */
+struct HttpRequest
+{
+    std::string_view method;  // 请求方法
+    std::string_view path;    // 路径（不含查询串）
+    std::string_view query;   // 查询串（不含'?'）
+    std::string_view body;    // 请求体
+    int minor_version = 1;    // HTTP/1.x的x
+    bool keep_alive = true;   // 响应后是否保持连接
+    int error_status = 0;     // 解析失败时建议回复的状态码
+
+    // 取查询参数的原始值（未做百分号解码），不存在时返回false
+    bool Param(std::string_view name, std::string_view &value) const
+    {
+        std::string_view rest = query;
+        while(!rest.empty())
+        {
+            size_t amp = rest.find('&');
+            std::string_view pair = rest.substr(0, amp);
+            size_t eq = pair.find('=');
+            if(pair.substr(0, eq) == name)
+            {
+                value = eq == std::string_view::npos ? std::string_view() : pair.substr(eq + 1);
+                return true;
+            }
+            if(amp == std::string_view::npos) break;
+            rest.remove_prefix(amp + 1);
+        }
+        return false;
+    }
+};
+
+// 忽略大小写比较首部名
+inline bool HttpNameEquals(std::string_view a, std::string_view b)
+{
+    if(a.size() != b.size()) return false;
+    for(size_t i = 0; i < a.size(); ++i)
+        if((a[i] | 0x20) != (b[i] | 0x20)) return false;
+    return true;
+}
+
+// 首部值中是否含有某个逗号分隔的记号（忽略大小写），用于Connection
+inline bool HttpHasToken(std::string_view value, std::string_view token)
+{
+    while(!value.empty())
+    {
+        size_t comma = value.find(',');
+        std::string_view item = value.substr(0, comma);
+        while(!item.empty() && (item.front() == ' ' || item.front() == '\t')) item.remove_prefix(1);
+        while(!item.empty() && (item.back() == ' ' || item.back() == '\t')) item.remove_suffix(1);
+        if(HttpNameEquals(item, token)) return true;
+        if(comma == std::string_view::npos) break;
+        value.remove_prefix(comma + 1);
+    }
+    return false;
+}
+
+/**
+ * @brief HTTP/1.1请求的增量解析器（每个连接一个）
+ * @note 与FrameIndex相同的约定：新到达的数据只扫描一次，首部未收全时记住已扫描位置，
+ *       首部收全而请求体未收全时记住解析结果，不从头重新解析；已取出的请求不立即删除，
+ *       由Compact统一移出缓冲区，因此一次读到的多个流水线请求可连续取出。
+ *       两次调用之间缓冲区只能在尾部追加，其他方式修改后须调用Reset。
+ *       不支持chunked请求体（回复501）
+ */
+class HttpParser
+{
+public:
+    // 取出下一个完整请求
+    template <typename Buffer>
+    HttpParseStatus Next(Buffer &package, HttpRequest &req)
+    {
+        const char *base = package.data();
+        if(header_end_ == 0)
+        {
+            // 从上次扫描位置回退3字节查找空行，"\r\n\r\n"可能跨两次到达的数据
+            size_t from = scanned_ > consumed_ + 3 ? scanned_ - 3 : consumed_;
+            const void *hit = memmem(base + from, package.size() - from, "\r\n\r\n", 4);
+            if(!hit)
+            {
+                scanned_ = package.size();
+                if(package.size() - consumed_ > http_max_header) return Fail(req, 431);
+                return http_incomplete;
+            }
+            header_end_ = (const char *)hit - base + 4;
+            if(header_end_ - consumed_ > http_max_header) return Fail(req, 431);
+            if(!ParseHead(std::string_view(base + consumed_, header_end_ - consumed_)))
+                return Fail(req, error_status_);
+        }
+
+        size_t end = header_end_ + content_length_;
+        if(package.size() < end) return http_incomplete;  // 请求体未收全
+
+        // 首部解析结果以相对请求起始的偏移保存，缓冲区扩容后仍然有效
+        const char *start = base + consumed_;
+        req.method = std::string_view(start, method_len_);
+        req.path = std::string_view(start + path_off_, path_len_);
+        req.query = std::string_view(start + query_off_, query_len_);
+        req.body = std::string_view(base + header_end_, content_length_);
+        req.minor_version = minor_version_;
+        req.keep_alive = keep_alive_;
+        req.error_status = 0;
+
+        consumed_ = end;
+        scanned_ = end;
+        header_end_ = 0;
+        content_length_ = 0;
+        return http_complete;
+    }
+
+    // 将已取出的请求移出缓冲区
+    template <typename Buffer>
+    void Compact(Buffer &package)
+    {
+        if(consumed_ == 0) return;
+        package.erase(0, consumed_);
+        scanned_ -= consumed_;
+        if(header_end_) header_end_ -= consumed_;
+        consumed_ = 0;
+    }
+
+    // 缓冲区被外部修改后重新开始
+    void Reset()
+    {
+        consumed_ = 0;
+        scanned_ = 0;
+        header_end_ = 0;
+        content_length_ = 0;
+    }
+
+    // 已取出但尚未移出缓冲区的字节数
+    size_t Consumed() const { return consumed_; }
+
+private:
+    HttpParseStatus Fail(HttpRequest &req, int status)
+    {
+        Reset();
+        req.error_status = status;
+        req.keep_alive = false;
+        return http_error;
+    }
+
+    // 解析请求行与首部，head不含下一请求的数据
+    bool ParseHead(std::string_view head)
+    {
+        keep_alive_ = true;
+        error_status_ = 400;
+        content_length_ = 0;
+
+        // 请求行：METHOD SP target SP HTTP/1.x CRLF
+        size_t eol = head.find("\r\n");
+        std::string_view line = head.substr(0, eol);
+        size_t sp1 = line.find(' ');
+        size_t sp2 = line.rfind(' ');
+        if(sp1 == std::string_view::npos || sp1 == 0 || sp2 <= sp1 + 1) return false;
+        std::string_view version = line.substr(sp2 + 1);
+        if(version.size() != 8 || version.substr(0, 7) != "HTTP/1." || version[7] < '0' || version[7] > '9')
+        {
+            error_status_ = 505;
+            return false;
+        }
+        minor_version_ = version[7] - '0';
+        keep_alive_ = minor_version_ >= 1;  // HTTP/1.0默认短连接
+
+        std::string_view target = line.substr(sp1 + 1, sp2 - sp1 - 1);
+        size_t q = target.find('?');
+        method_len_ = sp1;
+        path_off_ = sp1 + 1;
+        path_len_ = q == std::string_view::npos ? target.size() : q;
+        query_off_ = path_off_ + path_len_ + (q == std::string_view::npos ? 0 : 1);
+        query_len_ = q == std::string_view::npos ? 0 : target.size() - q - 1;
+
+        // 首部行：name: value CRLF，到空行为止
+        size_t pos = eol + 2;
+        while(pos < head.size())
+        {
+            eol = head.find("\r\n", pos);
+            if(eol == pos) break;  // 空行
+            std::string_view field = head.substr(pos, eol - pos);
+            pos = eol + 2;
+            size_t colon = field.find(':');
+            if(colon == std::string_view::npos || colon == 0) return false;
+            std::string_view name = field.substr(0, colon);
+            std::string_view value = field.substr(colon + 1);
+            while(!value.empty() && (value.front() == ' ' || value.front() == '\t')) value.remove_prefix(1);
+            while(!value.empty() && (value.back() == ' ' || value.back() == '\t')) value.remove_suffix(1);
+
+            if(HttpNameEquals(name, "content-length"))
+            {
+                size_t len = 0;
+                auto [end, ec] = std::from_chars(value.data(), value.data() + value.size(), len);
+                if(ec != std::errc() || end != value.data() + value.size()) return false;
+                if(len > http_max_body)
+                {
+                    error_status_ = 413;
+                    return false;
+                }
+                content_length_ = len;
+            }
+            else if(HttpNameEquals(name, "connection"))
+            {
+                if(HttpHasToken(value, "close")) keep_alive_ = false;
+                else if(HttpHasToken(value, "keep-alive")) keep_alive_ = true;
+            }
+            else if(HttpNameEquals(name, "transfer-encoding"))
+            {
+                error_status_ = 501;
+                return false;
+            }
+        }
+        return true;
+    }
+
+    int minor_version_ = 1;       // 当前请求的HTTP/1.x版本
+    bool keep_alive_ = true;      // 当前请求响应后是否保持连接
+    int error_status_ = 400;      // 解析失败时的状态码
+    size_t consumed_ = 0;         // 已取出的字节数
+    size_t scanned_ = 0;          // 已查找过空行的字节数
+    size_t header_end_ = 0;       // 当前请求首部结束位置，0表示首部未收全
+    size_t content_length_ = 0;   // 当前请求的请求体长度
+    uint16_t method_len_ = 0;     // 以下为相对请求起始的偏移与长度
+    uint16_t path_off_ = 0;
+    uint16_t path_len_ = 0;
+    uint16_t query_off_ = 0;
+    uint16_t query_len_ = 0;
+};
+
+// 状态码对应的原因短语
+inline const char *HttpReason(int status)
+{
+    switch(status)
+    {
+    case 200: return "OK";
+    case 400: return "Bad Request";
+    case 404: return "Not Found";
+    case 405: return "Method Not Allowed";
+    case 413: return "Content Too Large";
+    case 431: return "Request Header Fields Too Large";
+    case 501: return "Not Implemented";
+    case 503: return "Service Unavailable";
+    case 505: return "HTTP Version Not Supported";
+    default: return "Unknown";
+    }
+}
+
+/**
+ * @brief 预格式化的响应首部（每个线程一份）
+ * @note 状态行、Server、Date与Content-Type拼好后缓存，Date每秒最多重新格式化一次，
+ *       生成一个响应只需追加缓存的首部、Content-Length与正文
+ */
+class HttpHeaderCache
+{
+public:
+    static HttpHeaderCache &Local()
+    {
+        static thread_local HttpHeaderCache cache;
+        return cache;
+    }
+
+    // 取状态码200的首部前缀（以"\r\n"结尾的若干首部行），必要时刷新Date
+    std::string_view Ok()
+    {
+        Refresh();
+        return ok_;
+    }
+
+    // 当前的Date首部值
+    std::string_view Date()
+    {
+        Refresh();
+        return std::string_view(date_, date_len_);
+    }
+
+    // Date被重新格式化的次数
+    uint64_t Refreshes() const { return refreshes_; }
+
+private:
+    void Refresh()
+    {
+        time_t now = time(nullptr);
+        if(now == sec_) return;
+        sec_ = now;
+        struct tm tm;
+        gmtime_r(&now, &tm);
+        date_len_ = strftime(date_, sizeof(date_), "%a, %d %b %Y %H:%M:%S GMT", &tm);
+        ok_.assign("HTTP/1.1 200 OK\r\nServer: reactor\r\nDate: ");
+        ok_.append(date_, date_len_);
+        ok_.append("\r\nContent-Type: text/plain\r\n");
+        ++refreshes_;
+    }
+
+    time_t sec_ = -1;        // 缓存对应的秒
+    char date_[40];          // IMF-fixdate格式的日期
+    size_t date_len_ = 0;
+    std::string ok_;         // 200响应的首部前缀
+    uint64_t refreshes_ = 0;
+};
+
+/**
+ * @brief 把一个响应追加到out
+ * @param keep_alive 是否保持连接；HTTP/1.0客户端要求保持时显式回复keep-alive
+ */
+template <typename String>
+void HttpWriteResponse(String &out, int status, std::string_view body, bool keep_alive, int minor_version = 1)
+{
+    HttpHeaderCache &cache = HttpHeaderCache::Local();
+    if(status == 200)
+    {
+        out.append(cache.Ok());
+    }
+    else
+    {
+        char line[64];
+        int n = snprintf(line, sizeof(line), "HTTP/1.1 %d %s\r\n", status, HttpReason(status));
+        out.append(line, n);
+        out.append("Server: reactor\r\nDate: ");
+        out.append(cache.Date());
+        out.append("\r\nContent-Type: text/plain\r\n");
+    }
+    char digits[24];
+    size_t len = std::to_chars(digits, digits + sizeof(digits), body.size()).ptr - digits;
+    out.append("Content-Length: ");
+    out.append(digits, len);
+    if(!keep_alive) out.append("\r\nConnection: close");
+    else if(minor_version == 0) out.append("\r\nConnection: keep-alive");
+    out.append("\r\n\r\n");
+    out.append(body);
+}
+
+#endif
@@ -0,0 +1,369 @@
+#ifndef _LEADER_FOLLOWER_HPP_
+#define _LEADER_FOLLOWER_HPP_ 1
+
+#include <memory>
+#include <vector>
+#include <string>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <utility>
+#include <unordered_set>
+#include <pthread.h>
+#include <sys/eventfd.h>
+#include <sys/timerfd.h>
+#include "epoll.hpp"
+#include "log.hpp"
+#include "nocopy.hpp"
+#include "ring_queue.hpp"
+#include "admission.hpp"
+#include "timer_manager.hpp"
+#include "event_loop.hpp"
+#include "trace.hpp"
+
+/**
+ * @brief 领导者/跟随者线程池：所有工作线程等待同一个epoll
+ * @tparam Handler 请求处理器，同StaticEventLoop
+ * @tparam Codec 编解码器，同StaticEventLoop
+ * @note 连接以EPOLLONESHOT注册，一次就绪只交给一个线程，该线程读取、处理并发送后
+ *       以EPOLL_CTL_MOD重新布防。每个线程一次只取一个事件，等待中的线程由内核逐个唤醒
+ *       （相当于内核完成跟随者的提升），任何空闲线程都能接手任何就绪的连接，
+ *       单个请求耗时悬殊时慢请求不会拖住同一线程上的其他连接。
+ *       代价是每次处理多一次epoll_ctl，连接状态在线程间传递；
+ *       不支持文件发送、协程、共享内存传输与UDP
+ */
+template <typename Handler, typename Codec>
+class LeaderFollowerPool : public nocopy
+{
+public:
+    using request_t = typename Codec::request_t;
+    using state_t = typename Codec::state_t;
+
+    // 连接状态：同一时刻只有取到其事件的线程访问（空闲扫描只读last_active）
+    struct Conn
+    {
+        explicit Conn(int sock)
+            : fd(sock), addr(INADDR_ANY), port(0), family(AF_INET),
+              want_write(false), last_active(0), handoff(0) {}
+
+        int fd;                          // 套接字文件描述符
+        uint32_t addr;                   // 客户端IPv4地址（网络字节序）
+        uint16_t port;                   // 客户端端口号
+        sa_family_t family;              // 地址族：AF_INET或AF_UNIX
+        bool want_write;                 // 输出未发完，布防时同时关注EPOLLOUT
+        std::atomic<int64_t> last_active; // 最近一次处理的时间（steady时钟毫秒）
+        // 重新布防前release、取到事件后acquire：epoll已保证先后，此处让内存模型（及TSan）可见
+        std::atomic<uint32_t> handoff;
+        std::string in;                  // 输入缓冲区
+        std::string out;                 // 输出缓冲区
+        state_t state;                   // 解码状态
+    };
+
+    // rq: 新连接队列（可为空），其通知eventfd加入共享epoll
+    explicit LeaderFollowerPool(std::shared_ptr<RingQueue<ClientInf>> rq = nullptr,
+                                Handler handler = Handler(), Codec codec = Codec())
+        : rq_(rq),
+          handler_(std::move(handler)),
+          codec_(std::move(codec)),
+          idle_ms_((int64_t)default_alive_gap * 1000),
+          count_(0),
+          requests_(0),
+          quit_(false)
+    {
+        // 水平触发且不读清：退出时每个线程的epoll_wait都会返回
+        wakeup_fd_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        epoller_.EpollCtl(EPOLL_CTL_ADD, wakeup_fd_, EPOLLIN, &wakeup_fd_);
+        // 每秒一次的空闲扫描，由取到该事件的一个线程执行
+        timer_fd_ = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+        struct itimerspec spec = {{1, 0}, {1, 0}};
+        timerfd_settime(timer_fd_, 0, &spec, nullptr);
+        epoller_.EpollCtl(EPOLL_CTL_ADD, timer_fd_, EPOLLIN | EPOLLONESHOT, &timer_fd_);
+        // 共享epoll内的等待者本就逐个唤醒，EPOLLEXCLUSIVE只作用于跨多个epoll实例的情形，
+        // 且不能与EPOLLONESHOT同用；以EPOLLONESHOT注册，同一时刻只有一个线程领取新连接
+        if(rq_ && rq_->NotifyFd() >= 0)
+            epoller_.EpollCtl(EPOLL_CTL_ADD, rq_->NotifyFd(), EPOLLIN | EPOLLONESHOT, &rq_);
+    }
+
+    ~LeaderFollowerPool()
+    {
+        Stop();
+        Join();
+        for(Conn *conn : conns_)
+        {
+            close(conn->fd);
+            delete conn;
+        }
+        close(timer_fd_);
+        close(wakeup_fd_);
+    }
+
+    // 启动threads个工作线程
+    void Start(size_t threads)
+    {
+        for(size_t i = 0; i < threads; ++i)
+            threads_.emplace_back([this]() { Run(); });
+    }
+
+    // 请求所有工作线程退出（线程安全）
+    void Stop()
+    {
+        quit_ = true;
+        uint64_t one = 1;
+        write(wakeup_fd_, &one, sizeof(one));
+    }
+
+    // 等待所有工作线程退出
+    void Join()
+    {
+        for(auto &thread : threads_)
+            if(thread.joinable()) thread.join();
+    }
+
+    /// 添加已连接的非阻塞socket（线程安全）
+    void AddConnection(int sock, uint32_t ip = INADDR_ANY, uint16_t port = 0, sa_family_t family = AF_INET)
+    {
+        Conn *conn = new Conn(sock);
+        conn->addr = ip;
+        conn->port = port;
+        conn->family = family;
+        conn->last_active.store(EventLoop::NowMs(), std::memory_order_relaxed);
+        {
+            std::lock_guard<std::mutex> lock(mtx_);
+            conns_.insert(conn);
+        }
+        count_.fetch_add(1, std::memory_order_relaxed);
+        conn->handoff.fetch_add(1, std::memory_order_release);
+        if(!epoller_.EpollCtl(EPOLL_CTL_ADD, sock, EPOLLIN | EPOLLONESHOT, conn)) Close(conn);
+    }
+
+    /// 设置空闲连接超时时间（秒），0表示不超时；须在Start之前调用
+    void SetIdleTimeout(int seconds) { idle_ms_ = (int64_t)seconds * 1000; }
+
+    /// 设置准入控制（与Listener共用同一实例），语义同EventLoop::SetAdmission；须在Start之前调用
+    void SetAdmission(std::shared_ptr<AdmissionControl> admission) { admission_ = admission; }
+
+    /// 当前连接数
+    size_t ConnectionCount() { return count_.load(std::memory_order_relaxed); }
+
+    /// 累计处理的请求数
+    uint64_t Requests() { return requests_.load(std::memory_order_relaxed); }
+
+private:
+    // 每个线程持有处理器与编解码器的副本（编解码器内有复用的临时缓冲）
+    struct Worker
+    {
+        Handler handler;
+        Codec codec;
+        std::vector<request_t> reqs;  // 本批解码出的请求（复用）
+    };
+
+    void Run()
+    {
+        pthread_setname_np(pthread_self(), "worker");
+        Worker worker{handler_, codec_, {}};
+        struct epoll_event ev;
+        while(!quit_)
+        {
+            // 一次只取一个事件：多取的事件会排在本线程上，其余空闲线程无法接手
+            int n = epoller_.EpollWait(&ev, 1, -1);
+            if(n <= 0) continue;
+            if(ev.data.ptr == &wakeup_fd_) continue;
+            if(ev.data.ptr == &timer_fd_)
+            {
+                uint64_t ticks;
+                read(timer_fd_, &ticks, sizeof(ticks));
+                ExpireIdle();
+                epoller_.EpollCtl(EPOLL_CTL_MOD, timer_fd_, EPOLLIN | EPOLLONESHOT, &timer_fd_);
+                continue;
+            }
+            if(ev.data.ptr == &rq_)
+            {
+                TakeConnections();
+                continue;
+            }
+            Handle((Conn *)ev.data.ptr, ev.events, worker);
+        }
+    }
+
+    // 领取队列中的全部新连接（通知eventfd为信号量语义，每次read对应一个连接）
+    void TakeConnections()
+    {
+        uint64_t cnt;
+        while(read(rq_->NotifyFd(), &cnt, sizeof(cnt)) > 0)
+        {
+            auto client_inf = rq_->Pop();
+            if(!client_inf) continue;
+            if(client_inf->shm)
+            {
+                lg(Warning, "leader/follower mode does not support shared memory transport, client [%d] closed",
+                   client_inf->sockfd);
+                close(client_inf->sockfd);
+                continue;
+            }
+            AddConnection(client_inf->sockfd, client_inf->client_ip, client_inf->client_port, client_inf->family);
+        }
+        epoller_.EpollCtl(EPOLL_CTL_MOD, rq_->NotifyFd(), EPOLLIN | EPOLLONESHOT, &rq_);
+    }
+
+    // 处理一个连接的就绪事件，完成后重新布防（连接已关闭时除外）
+    void Handle(Conn *conn, uint32_t events, Worker &worker)
+    {
+        conn->handoff.load(std::memory_order_acquire);
+        TraceScope trace("dispatch", "fd", conn->fd, "events", events);
+        if(events & (EPOLLERR | EPOLLHUP)) events |= (EPOLLIN | EPOLLOUT);
+        if(events & EPOLLOUT && conn->want_write && !Flush(conn)) return;
+        if(events & EPOLLIN && !Recv(conn, worker)) return;
+        conn->last_active.store(EventLoop::NowMs(), std::memory_order_relaxed);
+        if(conn->in.empty()) worker.codec.Release(conn->state);
+        Arm(conn);
+    }
+
+    // 重新布防，此后连接可能已被其他线程取走，不能再访问
+    void Arm(Conn *conn)
+    {
+        int fd = conn->fd;
+        uint32_t events = EPOLLIN | EPOLLONESHOT | (conn->want_write ? (uint32_t)EPOLLOUT : 0u);
+        conn->handoff.fetch_add(1, std::memory_order_release);
+        epoller_.EpollCtl(EPOLL_CTL_MOD, fd, events, conn);
+    }
+
+    /**
+     * @brief 读取一次后解码、处理并发送响应，连接关闭时返回false
+     * @note 只读一次：水平触发下剩余数据在重新布防时立即再次就绪，可能由其他线程接手，
+     *       持续发送的连接不会独占线程
+     */
+    bool Recv(Conn *conn, Worker &worker)
+    {
+        // 用recvmsg取回msg_flags：seqpacket消息超过接收缓冲区时被截断，与EventLoop::Recv一致关闭连接
+        struct iovec iov = {buffer, sizeof(buffer)};
+        struct msghdr msg;
+        memset(&msg, 0, sizeof(msg));
+        msg.msg_iov = &iov;
+        msg.msg_iovlen = 1;
+        ssize_t n;
+        while(true)
+        {
+            n = recvmsg(conn->fd, &msg, 0);
+            if(n > 0 && (msg.msg_flags & MSG_TRUNC))
+            {
+                lg(Warning, "client [%d] message exceeds %lu bytes, closed", conn->fd, sizeof(buffer));
+                Close(conn);
+                return false;
+            }
+            if(n > 0) break;
+            if(n == 0)
+            {
+                lg(Info, "client [%d] quit", conn->fd);
+                Close(conn);
+                return false;
+            }
+            if(errno == EINTR) continue;
+            if(errno == EWOULDBLOCK) return true;  // 只因可写被唤醒
+            lg(Error, "recv from client [%d] false", conn->fd);
+            Close(conn);
+            return false;
+        }
+        conn->in.append(buffer, n);
+
+        // 先解码全部完整请求，按请求数扣减令牌后再处理，超限的请求不消耗计算
+        std::vector<request_t> &reqs = worker.reqs;
+        size_t decoded = 0;
+        while(true)
+        {
+            if(decoded == reqs.size()) reqs.emplace_back();
+            if(!worker.codec.Decode(conn->in, conn->state, reqs[decoded])) break;
+            ++decoded;
+        }
+        worker.codec.Consume(conn->in, conn->state);
+        if(decoded == 0) return true;
+        size_t admitted = decoded;
+        if(admission_ && conn->family == AF_INET) admitted = admission_->AdmitRequests(conn->addr, decoded);
+        for(size_t i = 0; i < admitted; ++i)
+            worker.codec.Encode(worker.handler(reqs[i]), conn->out);
+        requests_.fetch_add(admitted, std::memory_order_relaxed);
+
+        // 请求速率超限：尽力发出放行部分的响应后断开，与MessageHandler一致
+        if(admitted < decoded)
+        {
+            lg(Warning, "client [%d] request rate exceeded", conn->fd);
+            if(Flush(conn)) Close(conn);
+            return false;
+        }
+        return Flush(conn);
+    }
+
+    // 发送输出缓冲区，出错关闭连接时返回false
+    bool Flush(Conn *conn)
+    {
+        std::string &out = conn->out;
+        size_t sent = 0;
+        while(sent < out.size())
+        {
+            ssize_t n = send(conn->fd, out.data() + sent, out.size() - sent, MSG_NOSIGNAL);
+            if(n > 0) sent += n;
+            else if(n < 0 && errno == EWOULDBLOCK) break;
+            else if(n < 0 && errno == EINTR) continue;
+            else
+            {
+                lg(Error, "send to client [%d] false", conn->fd);
+                Close(conn);
+                return false;
+            }
+        }
+        out.erase(0, sent);
+        conn->want_write = !out.empty();
+        return true;
+    }
+
+    // 关闭连接并释放其状态（仅由取到其事件的线程调用）
+    void Close(Conn *conn)
+    {
+        epoller_.EpollCtl(EPOLL_CTL_DEL, conn->fd, 0);
+        {
+            // 先移出连接表再close，空闲扫描不会对已被复用的fd调用shutdown
+            std::lock_guard<std::mutex> lock(mtx_);
+            conns_.erase(conn);
+        }
+        close(conn->fd);
+        if(admission_ && conn->family == AF_INET)
+            admission_->ReleaseConnection(conn->addr);  // 归还来源IP的连接计数
+        count_.fetch_sub(1, std::memory_order_relaxed);
+        delete conn;
+    }
+
+    /**
+     * @brief 对超时未活动的连接调用shutdown
+     * @note 扫描线程不持有连接，不能直接关闭；shutdown后连接报告EPOLLHUP，
+     *       由取到该事件的线程读到0后按正常流程关闭
+     */
+    void ExpireIdle()
+    {
+        if(idle_ms_ <= 0) return;
+        int64_t now = EventLoop::NowMs();
+        std::lock_guard<std::mutex> lock(mtx_);
+        for(Conn *conn : conns_)
+        {
+            if(now - conn->last_active.load(std::memory_order_relaxed) < idle_ms_) continue;
+            lg(Info, "client [%d] idle timeout", conn->fd);
+            conn->last_active.store(now, std::memory_order_relaxed);  // 关闭前不重复处理
+            shutdown(conn->fd, SHUT_RDWR);
+        }
+    }
+
+    std::shared_ptr<RingQueue<ClientInf>> rq_;  // 新连接队列
+    Handler handler_;                            // 请求处理器（各线程复制一份）
+    Codec codec_;                                // 编解码器（各线程复制一份）
+    Epoll epoller_;                              // 所有线程共享的epoll实例
+    std::mutex mtx_;                             // 保护conns_
+    std::unordered_set<Conn *> conns_;           // 全部连接（空闲扫描与析构时遍历）
+    std::shared_ptr<AdmissionControl> admission_; // 准入控制（可为空）
+    std::vector<std::thread> threads_;           // 工作线程
+    int64_t idle_ms_;                            // 空闲超时（毫秒），0表示不超时
+    std::atomic<size_t> count_;                  // 当前连接数
+    std::atomic<uint64_t> requests_;             // 累计处理的请求数
+    int wakeup_fd_;                              // 退出通知eventfd
+    int timer_fd_;                               // 空闲扫描定时器
+    std::atomic<bool> quit_;                     // 退出标志
+};
+
+#endif
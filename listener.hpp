@@ -4,14 +4,25 @@
 #include <iostream>
 #include <memory>
 #include <thread>
+#include <atomic>
+#include <optional>
+#include <sys/eventfd.h>
 #include "tcp.hpp"         // TCP socket封装
 #include "event_loop.hpp"  // 事件循环
 #include "log.hpp"         // 日志系统
+#include "admission.hpp"   // 按来源IP的准入控制
 
 inline const uint16_t default_listen_port = 6349; // 默认监听端口
 
+// 连接交接队列（RingQueue）已满时的处理策略
+enum OverloadPolicy
+{
+    overload_pause,  // 暂停accept，新连接留在内核全连接队列中，工作线程取走连接后恢复
+    overload_reject, // 发送拒绝消息后立即关闭
+};
+
 /**
- * @brief TCP监听器类
+ * @brief 监听器类，支持TCP和Unix域socket（stream/seqpacket）
  * @note 通过环形队列实现与I/O线程的解耦
  */
 class Listener
@@ -20,79 +31,302 @@ public:
     /**
      * @brief 构造函数
      * @param port 监听端口号
+     * @param backlog 全连接队列长度
+     * @param opts 监听socket及每个新连接使用的socket选项
      */
-    Listener(uint16_t port = default_listen_port)
+    Listener(uint16_t port = default_listen_port,
+             int backlog = default_backlog,
+             const SockOpts &opts = SockOpts())
         : port_(port),
-        sock_(new Sock()) // 创建TCP socket封装对象
+        backlog_(backlog),
+        opts_(opts),
+        type_(SOCK_STREAM),
+        sock_(new Sock()), // 创建TCP socket封装对象
+        idle_fd_(-1),
+        policy_(overload_pause),
+        space_fd_(-1),
+        paused_(false),
+        pauses_(0),
+        rejected_(0)
     {
     }
 
+    /**
+     * @brief 构造Unix域socket监听器，供同机客户端绕过TCP协议栈
+     * @param path socket文件路径
+     * @param type SOCK_STREAM或SOCK_SEQPACKET
+     *        （seqpacket的单条消息需小于EventLoop接收缓冲区）
+     * @param backlog 全连接队列长度
+     */
+    Listener(const std::string &path, int type = SOCK_STREAM, int backlog = default_backlog)
+        : port_(0),
+        backlog_(backlog),
+        path_(path),
+        type_(type),
+        sock_(new Sock()),
+        idle_fd_(-1),
+        policy_(overload_pause),
+        space_fd_(-1),
+        paused_(false),
+        pauses_(0),
+        rejected_(0)
+    {
+    }
+
+    ~Listener()
+    {
+        if (idle_fd_ >= 0) close(idle_fd_);
+        if (space_fd_ >= 0) close(space_fd_);
+        if (parked_) close(parked_->sockfd);
+        if (!path_.empty()) unlink(path_.c_str());
+    }
+
     /**
      * @brief 初始化监听socket
      */
     void Init()
     {
+        if (!path_.empty())
+        {
+            sock_->Socket(type_, AF_UNIX);
+            sock_->BindUnix(path_);
+            sock_->Listen(backlog_);
+            SetNonBlockOrDie(sock_->GetSockfd());
+            idle_fd_ = open("/dev/null", O_RDONLY | O_CLOEXEC);
+            space_fd_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+            return;
+        }
         sock_->Socket();  // 创建socket
+        Sock::ApplyListenOpts(sock_->GetSockfd(), opts_); // 设置监听选项
         sock_->Bind(port_); // 绑定端口
-        sock_->Listen();    // 开始监听
+        sock_->Listen(backlog_); // 开始监听
         SetNonBlockOrDie(sock_->GetSockfd()); // 设置为非阻塞模式
+        // 预留一个空闲fd，文件描述符耗尽时用于接受并关闭连接
+        idle_fd_ = open("/dev/null", O_RDONLY | O_CLOEXEC);
+        space_fd_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC); // 队列腾出空间时的通知
     }
 
     /**
      * @brief 接受客户端连接的主循环
      * @param conn 持有EventLoop引用的Connection对象
+     * @note 边缘触发下一次唤醒需把全连接队列取空
      */
     void Accepter(std::weak_ptr<Connection> conn)
     {
+        if (paused_.load(std::memory_order_relaxed)) return; // 暂停期间的残留事件
         auto connection = conn.lock();
+        auto event_loop = connection->el.lock();
+        int listen_sockfd = sock_->GetSockfd();
+        bool is_unix = !path_.empty();
         while (true)
         {
-            int listen_sockfd = sock_->GetSockfd();
             struct sockaddr_in client;
             socklen_t len = sizeof(client);
-            // 非阻塞accept
-            int client_sockfd = accept(listen_sockfd, (sockaddr *)&client, &len);
+            // 非阻塞accept，新socket直接带上O_NONBLOCK|O_CLOEXEC，省去两次fcntl
+            // Unix域socket的对端地址没有意义，不取回
+            int client_sockfd = accept4(listen_sockfd,
+                                        is_unix ? nullptr : (sockaddr *)&client,
+                                        is_unix ? nullptr : &len,
+                                        SOCK_NONBLOCK | SOCK_CLOEXEC);
+            event_loop->CountSyscall(sys_accept);
             
             if (client_sockfd == -1)
             {
                 if (errno == EWOULDBLOCK)
                     break;  // 无新连接时退出循环
-                else if (errno == EINTR)
-                    continue; // 被信号中断则重试
+                else if (errno == EINTR || errno == ECONNABORTED)
+                    continue; // 被信号中断或连接已被对端放弃则重试
+                else if (errno == EMFILE || errno == ENFILE)
+                {
+                    // fd耗尽：连接会一直留在队列中使边缘触发失效或空转，
+                    // 释放预留fd接受后立即关闭，再重新预留
+                    if (RejectWithIdleFd(listen_sockfd))
+                        continue;
+                    break; // 无预留fd可用，等待下次唤醒，避免空转
+                }
                 else
                 {
                     // 记录accept错误日志
                     lg(Error, "listening sock accept false, [%d]: %s", errno, strerror(errno));
-                    continue;
+                    break;
                 }
             }
             
-            // 获取客户端地址信息
-            std::string client_ip;
-            uint16_t client_port;
-            Sock::GetAddrAndPort(client, client_ip, client_port);
-            lg(Info, "accept a new client [%s: %d]", client_ip.c_str(), client_port);
+            if (is_unix)
+            {
+                lg(Info, "accept a new client [unix: %s]", path_.c_str());
+                ClientInf ci{
+                    .sockfd = client_sockfd,
+                    .client_ip = INADDR_ANY,
+                    .client_port = 0,
+                    .family = AF_UNIX,
+                    .shm = shm_
+                };
+                if (!Handoff(event_loop, ci)) break; // 已暂停accept
+                continue;
+            }
+
+            // 准入检查在格式化日志、设置选项和入队之前，被拒绝的来源不消耗工作线程
+            if (admission_ && !admission_->AdmitConnection(client.sin_addr.s_addr))
+            {
+                Reset(client_sockfd);
+                continue;
+            }
+
+            uint16_t client_port = ntohs(client.sin_port);
+            if (lg.Enabled())  // 地址只为日志格式化，关闭日志时省去每次accept的inet_ntop
+            {
+                char ip[INET_ADDRSTRLEN];
+                lg(Info, "accept a new client [%s: %d]",
+                   Sock::AddrToStr(client.sin_addr.s_addr, ip, sizeof(ip)), client_port);
+            }
 
-            // 设置客户端socket为非阻塞
-            SetNonBlockOrDie(client_sockfd);
+            // 按监听器配置设置连接选项
+            Sock::ApplyConnOpts(client_sockfd, opts_);
 
             // 通过EventLoop的环形队列传递连接信息
-            auto event_loop = connection->el.lock();
             ClientInf ci{
                 .sockfd = client_sockfd,
-                .client_ip = client_ip,
-                .client_port = client_port
+                .client_ip = client.sin_addr.s_addr,
+                .client_port = client_port,
+                .family = AF_INET
             };
-            event_loop->rq_->Push(ci); // 入队操作
+            if (!Handoff(event_loop, ci)) break; // 已暂停accept
         }
     }
 
+    /// 本监听器接入的Unix域连接改走共享内存传输（工作线程握手后关闭socket）
+    void EnableShm() { shm_ = true; }
+
     /// 获取监听socket文件描述符
     int Fd() { return sock_->GetSockfd(); }
 
+    /**
+     * @brief 开启按来源IP的准入控制（仅TCP）
+     * @note 工作线程的EventLoop须设置同一个实例，连接关闭时归还计数
+     */
+    void SetAdmission(std::shared_ptr<AdmissionControl> admission) { admission_ = admission; }
+
+    /**
+     * @brief 设置交接队列满时的处理策略（默认暂停accept）
+     * @param reject_msg overload_reject时关闭前发送给客户端的数据（已编码），可为空
+     */
+    void SetOverloadPolicy(OverloadPolicy policy, const std::string &reject_msg = "")
+    {
+        policy_ = policy;
+        reject_msg_ = reject_msg;
+    }
+
+    /// 是否正处于暂停accept状态（可跨线程读取）
+    bool Paused() { return paused_.load(std::memory_order_relaxed); }
+
+    /// 因队列满而暂停accept的次数
+    uint64_t Pauses() { return pauses_.load(std::memory_order_relaxed); }
+
+    /// 因队列满而拒绝的连接数
+    uint64_t Rejected() { return rejected_.load(std::memory_order_relaxed); }
+
 private:
+    /**
+     * @brief 把新连接交给工作线程，队列满时按策略处理
+     * @return 可以继续accept返回true；已暂停返回false
+     */
+    bool Handoff(std::shared_ptr<EventLoop> &event_loop, const ClientInf &ci)
+    {
+        if (event_loop->rq_->Push(ci)) return true;
+        if (policy_ == overload_reject)
+        {
+            // 未交给工作线程的连接不会经过EventLoop::Except，在此归还准入计数
+            if (admission_ && ci.family == AF_INET) admission_->ReleaseConnection(ci.client_ip);
+            if (!reject_msg_.empty())
+                send(ci.sockfd, reject_msg_.data(), reject_msg_.size(), MSG_DONTWAIT | MSG_NOSIGNAL);
+            close(ci.sockfd);
+            rejected_.fetch_add(1, std::memory_order_relaxed);
+            lg(Warning, "task queue full, reject client sockfd: %d", ci.sockfd);
+            return true;
+        }
+        // 暂停：暂存这个已accept的连接，其余连接留在内核全连接队列中
+        parked_ = ci;
+        Pause(event_loop);
+        return false;
+    }
+
+    // 停止监听可读事件，并在队列腾出空间时得到通知
+    void Pause(std::shared_ptr<EventLoop> &event_loop)
+    {
+        paused_.store(true, std::memory_order_relaxed);
+        pauses_.fetch_add(1, std::memory_order_relaxed);
+        lg(Warning, "task queue full, pause accepting on sockfd: %d", Fd());
+        event_loop->UpdateEvents(Fd(), 0);
+        if (!space_registered_)
+        {
+            event_loop->AddConnection(space_fd_, EPOLLIN | EPOLLET,
+                                      std::bind(&Listener::OnSpace, this, std::placeholders::_1),
+                                      nullptr, nullptr, INADDR_ANY, 0, true);
+            space_registered_ = true;
+        }
+        event_loop->rq_->WaitSpace(space_fd_); // 已有空间时立即写入space_fd_
+    }
+
+    // 队列有空间：先交出暂存的连接，再恢复accept
+    void OnSpace(std::weak_ptr<Connection> conn)
+    {
+        auto event_loop = conn.lock()->el.lock();
+        uint64_t cnt;
+        while (read(space_fd_, &cnt, sizeof(cnt)) > 0);
+        if (!paused_.load(std::memory_order_relaxed)) return;
+        if (parked_)
+        {
+            if (!event_loop->rq_->Push(*parked_))
+            {
+                event_loop->rq_->WaitSpace(space_fd_);
+                return;
+            }
+            parked_.reset();
+        }
+        paused_.store(false, std::memory_order_relaxed);
+        lg(Info, "task queue has space, resume accepting on sockfd: %d", Fd());
+        // 重新关注可读事件；全连接队列非空时epoll立即报告，Accepter继续取走积压的连接
+        event_loop->UpdateEvents(Fd(), EPOLLIN | EPOLLET);
+    }
+
+    // 以RST立即关闭被拒绝的连接，本端不进入TIME_WAIT
+    static void Reset(int sockfd)
+    {
+        struct linger lin = {1, 0};
+        setsockopt(sockfd, SOL_SOCKET, SO_LINGER, &lin, sizeof(lin));
+        close(sockfd);
+    }
+
+    // 用预留fd接受一个连接并立即关闭，返回是否成功取走了一个连接
+    bool RejectWithIdleFd(int listen_sockfd)
+    {
+        if (idle_fd_ < 0) return false;
+        lg(Warning, "too many open files, reject a pending client");
+        close(idle_fd_);
+        int fd = accept(listen_sockfd, nullptr, nullptr);
+        if (fd >= 0) close(fd);
+        idle_fd_ = open("/dev/null", O_RDONLY | O_CLOEXEC);
+        return fd >= 0;
+    }
+
     uint16_t port_;             // 监听端口
+    int backlog_;               // 全连接队列长度
+    SockOpts opts_;             // socket选项配置（仅TCP）
+    std::string path_;          // Unix域socket路径，为空表示TCP
+    int type_;                  // socket类型（Unix域可为SOCK_SEQPACKET）
+    bool shm_ = false;          // 是否为共享内存传输的握手socket
     std::shared_ptr<Sock> sock_; // TCP socket封装对象
+    int idle_fd_;               // 预留的空闲fd（应对EMFILE）
+    std::shared_ptr<AdmissionControl> admission_; // 准入控制，为空表示不限制
+    OverloadPolicy policy_;     // 交接队列满时的处理策略
+    std::string reject_msg_;    // 拒绝时发送的数据
+    int space_fd_;              // 队列腾出空间时的通知eventfd
+    bool space_registered_ = false; // space_fd_是否已注册到监听EventLoop
+    std::optional<ClientInf> parked_; // 暂停时暂存的已accept连接
+    std::atomic<bool> paused_;  // 是否暂停accept
+    std::atomic<uint64_t> pauses_;   // 暂停次数
+    std::atomic<uint64_t> rejected_; // 拒绝的连接数
 };
 
 #endif
\ No newline at end of file
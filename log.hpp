@@ -27,7 +27,8 @@ enum PrintWay
 {
     Screen = 1,
     Onefile,
-    Classfile
+    Classfile,
+    Silent      // 关闭输出（基准测试等场景）
 };
 
 class log
@@ -42,6 +43,11 @@ public:
     {
         printMethod = method;
     }
+    // 是否输出日志：热路径上只为日志准备参数时先检查，关闭时省去格式化
+    bool Enabled() const
+    {
+        return printMethod != Silent;
+    }
     std::string levelToString(int level)
     {
         switch (level)
@@ -81,6 +87,8 @@ public:
 
     void operator()(int level, const char *format, ...)
     {
+        if (printMethod == Silent)
+            return;
         time_t t = time(nullptr);
         struct tm *ctime = localtime(&t);
         // left information(error level and the local time)
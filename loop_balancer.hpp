@@ -0,0 +1,108 @@
+#ifndef _LOOP_BALANCER_HPP_
+#define _LOOP_BALANCER_HPP_ 1
+
+#include <memory>
+#include <vector>
+#include <mutex>
+#include "event_loop.hpp"
+#include "log.hpp"
+#include "nocopy.hpp"
+
+inline const int default_balance_ms = 1000;      // 默认检查周期（毫秒）
+inline const double default_balance_busy = 0.5;  // 最忙的循环忙碌比例达到该值才迁移
+inline const double default_balance_gap = 0.25;  // 最忙与最闲的循环忙碌比例相差达到该值才迁移
+
+/**
+ * @brief 工作事件循环之间的连接再均衡
+ * @note 周期性比较各循环的忙碌比例（处理耗时占墙钟时间的比例，来自LoopStats::work_ns），
+ *       不均衡时让最忙的循环把约一半差额的流量迁往最闲的循环。
+ *       迁移在源循环线程中进行，Check本身只读取原子统计并投递任务，可在任意线程周期调用
+ */
+class LoopBalancer : public nocopy
+{
+public:
+    LoopBalancer(int interval_ms = default_balance_ms, double busy = default_balance_busy,
+                 double gap = default_balance_gap)
+        : interval_ms_(interval_ms), busy_(busy), gap_(gap), rounds_(0) {}
+
+    /// 登记一个工作事件循环（线程安全）
+    void Add(std::shared_ptr<EventLoop> loop)
+    {
+        std::lock_guard<std::mutex> lock(mtx_);
+        loops_.push_back({loop, loop->Stats().work_ns, EventLoop::NowNs(), 0});
+    }
+
+    /**
+     * @brief 统计上次检查以来各循环的忙碌比例，必要时发起一次迁移
+     * @return 发起迁移时返回true
+     */
+    bool Check()
+    {
+        std::lock_guard<std::mutex> lock(mtx_);
+        if (loops_.size() < 2) return false;
+        int64_t now = EventLoop::NowNs();
+        for (auto &entry : loops_)
+        {
+            uint64_t work = entry.loop->Stats().work_ns;
+            int64_t elapsed = now - entry.sampled_at;
+            entry.busy = elapsed > 0 ? (double)(work - entry.work_ns) / elapsed : 0;
+            entry.work_ns = work;
+            entry.sampled_at = now;
+        }
+        Entry *hot = &loops_[0], *cold = &loops_[0];
+        for (auto &entry : loops_)
+        {
+            if (entry.busy > hot->busy) hot = &entry;
+            if (entry.busy < cold->busy) cold = &entry;
+        }
+
+        bool migrate = hot->busy >= busy_ && hot->busy - cold->busy >= gap_;
+        for (auto &entry : loops_)
+        {
+            auto loop = entry.loop;
+            if (migrate && &entry == hot)
+            {
+                // 迁走差额的一半，两者大致拉平
+                double share = (hot->busy - cold->busy) / (2 * hot->busy);
+                auto target = cold->loop;
+                lg(Debug, "rebalance: busy %.2f -> %.2f, share %.2f", hot->busy, cold->busy, share);
+                loop->QueueInLoop([loop, target, share]() { loop->MigrateTo(target, share); });
+            }
+            else
+            {
+                // 各循环同步开始新的流量统计周期
+                loop->QueueInLoop([loop]() { loop->ResetTraffic(); });
+            }
+        }
+        if (migrate) ++rounds_;
+        return migrate;
+    }
+
+    /// 检查周期（毫秒）
+    int Interval() { return interval_ms_; }
+
+    /// 已发起的迁移次数
+    uint64_t Rounds()
+    {
+        std::lock_guard<std::mutex> lock(mtx_);
+        return rounds_;
+    }
+
+private:
+    struct Entry
+    {
+        std::shared_ptr<EventLoop> loop;
+        uint64_t work_ns;   // 上次检查时的累计处理耗时
+        int64_t sampled_at; // 上次检查的时间
+        double busy;        // 最近一个周期的忙碌比例
+    };
+
+    int interval_ms_;           // 检查周期
+    double busy_;               // 迁移的忙碌比例下限
+    double gap_;                // 迁移的忙碌比例差下限
+    std::mutex mtx_;            // 保护loops_与rounds_
+    std::vector<Entry> loops_;  // 登记的工作循环
+    uint64_t rounds_;           // 已发起的迁移次数
+};
+
+#endif
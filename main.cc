@@ -9,32 +9,105 @@
 #include "ring_queue.hpp"
 #include "listener.hpp"
 #include "server_cal.hpp"
+#include "datagram.hpp"
+#include "admission.hpp"
+#include "capture.hpp"
+#include "trace.hpp"
+#include "loop_balancer.hpp"
+#include "leader_follower.hpp"
 
 const size_t default_thread_num = 5;  // 默认工作线程数
+const size_t default_queue_cap = 10;   // 默认任务队列容量
+const size_t massive_queue_cap = 4096; // 海量连接模式下的任务队列容量
 
 ServerCal sc;  // 业务逻辑处理器实例
+std::shared_ptr<AdmissionControl> admission;  // 按来源IP的准入控制（未配置时为空）
+OverloadPolicy overload = overload_pause;     // 任务队列满时的处理策略
+std::shared_ptr<CaptureWriter> capture;       // 流量录制（未开启时为空）
+std::shared_ptr<LoopBalancer> balancer;       // 工作线程间的连接再均衡（未开启时为空）
+bool persistent_out = false;                  // 写事件常驻模式
+int syscall_report_s = 0;                     // 每隔多少秒输出每请求的系统调用次数，0表示不输出
+bool http_mode = false;                       // stream连接使用HTTP/1.1协议
+bool leader_follower = false;                 // 领导者/跟随者模式：工作线程共享一个epoll
 
 /**
  * @brief 消息处理回调函数
  * @param wconnectiion 客户端连接弱引用
- * @note 处理客户端输入并返回计算结果
+ * @note 批量处理输入缓冲区中的全部请求，响应合并后发送一次
  */
 void MessageHandler(std::weak_ptr<Connection> wconnectiion) {
     auto connection = wconnectiion.lock();
-    std::string &inf = connection->Inbuffer();  // 获取输入缓冲区
-    std::string outinf;
+    buffer_t &inf = connection->Inbuffer();  // 获取输入缓冲区
     
-    while (true) {
-        outinf = sc.Calculator(inf);  // 调用业务逻辑处理
-        if (outinf.empty()) return;   // 无输出则结束
-        
-        connection->AppendOutBuffer(outinf);  // 写入输出缓冲区
-        
-        // 通过EventLoop发送响应
-        auto wsender = connection->el;
-        auto sender = wsender.lock();
-        sender->Send(connection);
+    // 解码后先按请求数扣减令牌再求值，超限的请求不消耗计算；响应直接序列化到输出缓冲区尾部
+    size_t decoded = 0;
+    size_t n = sc.CalculatorBatch(inf, connection->OutTail(), connection->Frames(), [&](size_t k) {
+        decoded = k;
+        if (connection->family_ != AF_INET || !admission) return k;
+        return admission->AdmitRequests(connection->addr_, k);
+    });
+
+    auto wsender = connection->el;
+    auto sender = wsender.lock();
+    // 请求速率超限：只回复放行的部分，发送完后断开
+    if (n < decoded) {
+        lg(Warning, "client [%s: %d] request rate exceeded", connection->Ip(), connection->port_);
+        if (n == 0) {
+            connection->except_cb(connection);
+            return;
+        }
+        inf.clear();
+        connection->Frames().Reset();
+        connection->close_after_send_ = true;
+    }
+    if (n == 0) return;  // 无完整请求则结束
+
+    // 通过EventLoop发送响应
+    sender->CountRequests(n);
+    sender->Send(connection);
+}
+
+/**
+ * @brief HTTP消息处理回调函数
+ * @param wconnectiion 客户端连接弱引用
+ * @note 与MessageHandler相同，批量处理全部流水线请求后发送一次；
+ *       每个请求解析后、求值前扣减令牌，超限时只回复放行的部分；
+ *       客户端要求关闭、请求格式错误或速率超限时，响应发出后关闭连接
+ */
+void HttpMessageHandler(std::weak_ptr<Connection> wconnectiion) {
+    auto connection = wconnectiion.lock();
+    bool close = false;
+    bool limited = false;
+    size_t n = sc.CalculatorHttp(connection->Inbuffer(), connection->OutTail(), connection->Http(), close,
+                                 [&](size_t k) {
+        if (connection->family_ != AF_INET || !admission) return k;
+        size_t admitted = admission->AdmitRequests(connection->addr_, k);
+        limited = admitted < k;
+        return admitted;
+    });
+
+    auto sender = connection->el.lock();
+    if (limited) {
+        lg(Warning, "client [%s: %d] request rate exceeded", connection->Ip(), connection->port_);
+        if (n == 0) {
+            connection->except_cb(connection);
+            return;
+        }
     }
+    if (n == 0) return;
+
+    sender->CountRequests(n);
+    connection->close_after_send_ = close;
+    sender->Send(connection);
+}
+
+/**
+ * @brief UDP数据报处理函数
+ * @param request 数据报内容（一个或多个协议帧）
+ * @param reply 回复内容
+ */
+void DatagramHandler(std::string &request, std::string &reply) {
+    sc.CalculatorBatch(request, reply);
 }
 
 /**
@@ -48,74 +121,243 @@ void TaskPush(std::weak_ptr<RingQueue<ClientInf>> wrq, std::weak_ptr<EventLoop>
     auto el = wel.lock();
     
     if (auto client_inf = rq->Pop()) {  // 从队列获取新连接
-        el->AddConnection(
+        if (client_inf->shm) {  // 同机客户端：握手后经共享内存收发
+            el->AddShmConnection(client_inf->sockfd);
+            return;
+        }
+        auto connection = el->AddConnection(
             client_inf->sockfd, 
-            EPOLLIN | EPOLLET,  // 边缘触发模式
+            el->ConnEvents(),  // 边缘触发模式（常驻模式下同时注册EPOLLOUT|EPOLLRDHUP）
             std::bind(&EventLoop::Recv, el, std::placeholders::_1),  // 读回调
             std::bind(&EventLoop::Send, el, std::placeholders::_1),  // 写回调
             std::bind(&EventLoop::Except, el, std::placeholders::_1), // 异常回调
             client_inf->client_ip, 
             client_inf->client_port
         );
+        connection->family_ = client_inf->family;
     }
 }
 
 /**
- * @brief 监听线程处理函数
- * @param rq 环形队列
- * @param port 监听端口
+ * @brief 将监听器注册到监听EventLoop
  */
-void ListenHandler(std::shared_ptr<RingQueue<ClientInf>> rq, uint16_t port) {
-    std::shared_ptr<Listener> lt(new Listener(port));  // 创建监听器
-    lt->Init();  // 初始化监听socket
-    
-    // 主EventLoop只负责监听
-    std::shared_ptr<EventLoop> baser(new EventLoop(rq));
+void AddListener(std::shared_ptr<EventLoop> baser, std::shared_ptr<Listener> lt) {
+    // 拒绝策略下先回复一个“服务器忙”响应再关闭，客户端可据此退避
+    std::string busy;
+    if (http_mode) HttpWriteResponse(busy, 503, HttpReason(503), false);
+    else Response(0, server_busy).SerializeTo(busy);
+    lt->SetOverloadPolicy(overload, busy);
     baser->AddConnection(
         lt->Fd(), 
         EPOLLIN | EPOLLET, 
         std::bind(&Listener::Accepter, lt, std::placeholders::_1),  // 接受新连接
         nullptr,  // 无需写回调
         nullptr,  // 无需异常回调
-        "0.0.0.0", 
+        INADDR_ANY, 
         0, 
         true  // 标记为监听socket
     );
+}
+
+/**
+ * @brief 监听线程处理函数
+ * @param rq 环形队列
+ * @param port 监听端口
+ * @param unix_path Unix域stream socket路径（为空则不监听）
+ * @param seqpacket_path Unix域seqpacket socket路径（为空则不监听）
+ * @param shm_path 共享内存传输握手socket路径（为空则不监听）
+ * @param opts TCP连接socket选项
+ */
+void ListenHandler(std::shared_ptr<RingQueue<ClientInf>> rq, uint16_t port,
+                   std::string unix_path, std::string seqpacket_path, std::string shm_path, SockOpts opts) {
+    pthread_setname_np(pthread_self(), "listener");  // 跟踪与top中显示的线程名
+    // 主EventLoop只负责监听
+    std::shared_ptr<EventLoop> baser(new EventLoop(rq));
+
+    std::shared_ptr<Listener> lt(new Listener(port, default_backlog, opts));  // 创建监听器
+    lt->SetAdmission(admission);  // accept后立即做来源IP准入检查
+    lt->Init();  // 初始化监听socket
+    AddListener(baser, lt);
+
+    // 同机客户端可走Unix域socket，与TCP共用工作线程和协议处理
+    std::shared_ptr<Listener> ult, slt, mlt;
+    if (!unix_path.empty()) {
+        ult.reset(new Listener(unix_path, SOCK_STREAM));
+        ult->Init();
+        AddListener(baser, ult);
+    }
+    if (!seqpacket_path.empty()) {
+        slt.reset(new Listener(seqpacket_path, SOCK_SEQPACKET));
+        slt->Init();
+        AddListener(baser, slt);
+    }
+    if (!shm_path.empty()) {
+        mlt.reset(new Listener(shm_path, SOCK_STREAM));
+        mlt->EnableShm();
+        mlt->Init();
+        AddListener(baser, mlt);
+    }
+    // 监听线程周期检查各工作线程负载，迁移在工作线程中进行
+    if (balancer) baser->RunEvery(balancer->Interval(), []() { balancer->Check(); });
     baser->Loop();  // 启动事件循环
 }
 
+/**
+ * @brief 在事件循环上注册UDP端点，与TCP共用计算器逻辑
+ * @param port UDP端口（SO_REUSEPORT，每个循环一个socket）
+ */
+void AddDatagramEndpoint(std::shared_ptr<EventLoop> loop, uint16_t port) {
+    std::shared_ptr<DatagramEndpoint> udp(new DatagramEndpoint(port, DatagramHandler));
+    udp->Init();
+    loop->AddConnection(
+        udp->Fd(),
+        EPOLLIN | EPOLLET,
+        std::bind(&DatagramEndpoint::Reader, udp, std::placeholders::_1),
+        nullptr,
+        nullptr,
+        INADDR_ANY,
+        port,
+        true  // 不参与空闲超时
+    );
+}
+
 /**
  * @brief 工作线程处理函数
  * @param rq 环形队列
+ * @param port UDP端口（每个工作线程一个SO_REUSEPORT socket）
+ * @param reserve 预计本线程承载的连接数，0表示不预留
+ * @param spin_idle_us 忙轮询退避阈值（微秒），0表示不忙轮询
+ * @param busy_usecs epoll内核忙轮询时长（微秒），0表示关闭
  */
-void EventHandler(std::shared_ptr<RingQueue<ClientInf>> rq) {
+void EventHandler(std::shared_ptr<RingQueue<ClientInf>> rq, uint16_t port, size_t reserve,
+                  int spin_idle_us, int busy_usecs) {
+    pthread_setname_np(pthread_self(), "worker");
     // 创建工作EventLoop，设置消息处理和任务获取回调
     std::shared_ptr<EventLoop> task_handler(
-        new EventLoop(rq, MessageHandler, TaskPush)
+        new EventLoop(rq, http_mode ? HttpMessageHandler : MessageHandler, TaskPush)
     );
+    if (reserve) task_handler->Reserve(reserve);  // 海量连接模式预留容量
+    if (spin_idle_us) task_handler->EnableBusyPoll(spin_idle_us, busy_usecs);  // 低延迟模式独占CPU
+    task_handler->SetAdmission(admission);  // 连接关闭时归还来源IP的连接计数
+    if (capture) task_handler->SetCapture(capture);  // 录制各连接收到的字节流
+    if (balancer) balancer->Add(task_handler);       // 参与连接再均衡
+    if (persistent_out) task_handler->EnablePersistentOut();  // 连接一次注册读写事件，不再切换EPOLLOUT
+    if (syscall_report_s) {
+        EventLoop *loop = task_handler.get();
+        task_handler->RunEvery(syscall_report_s * 1000, [loop, last = SyscallStats{}]() mutable {
+            SyscallStats now = loop->Syscalls();
+            SyscallStats diff = now - last;
+            last = now;
+            if (diff.requests) lg(Info, "syscalls per request: %s", diff.ToString().c_str());
+        });
+    }
+
+    AddDatagramEndpoint(task_handler, port);
     task_handler->Loop();  // 启动事件循环
 }
 
+/**
+ * @brief UDP线程处理函数（领导者/跟随者模式）
+ * @param port UDP端口
+ * @note 工作线程共享的epoll只接管流式连接，UDP由独立的EventLoop线程收发，协议处理不变
+ */
+void DatagramThread(uint16_t port) {
+    pthread_setname_np(pthread_self(), "udp");
+    std::shared_ptr<EventLoop> loop(new EventLoop());
+    AddDatagramEndpoint(loop, port);
+    loop->Loop();
+}
+
 int main(int argc, char *argv[]) {
     // 参数处理
-    uint16_t port;
-    if(argc == 1) port = 6667;  // 默认端口
-    else if(argc == 2) port = std::stoi(argv[1]);
-    else {
-        std::cerr << "Usage: " << argv[0] << " [port]" << std::endl;
-        return 1;
+    uint16_t port = 6667;  // 默认端口
+    std::string unix_path, seqpacket_path, shm_path;
+    size_t max_conns = 0;  // 海量连接模式：预计的最大连接数
+    int spin_idle_us = 0;  // 忙轮询模式：无事件多久后退回阻塞等待
+    int busy_usecs = 0;    // 内核忙轮询时长（SO_BUSY_POLL与epoll参数）
+    AdmissionOpts limits;  // 按来源IP的连接数与速率限制
+    std::string trace_path;  // 跟踪导出文件（Chrome trace JSON）
+    int opt;
+    while ((opt = getopt(argc, argv, "u:s:M:c:b:B:m:a:r:o:w:T:L:eS:HF")) != -1) {
+        switch (opt) {
+        case 'u': unix_path = optarg; break;       // Unix域stream socket
+        case 's': seqpacket_path = optarg; break;  // Unix域seqpacket socket
+        case 'M': shm_path = optarg; break;        // 共享内存传输的握手socket
+        case 'c': max_conns = std::stoul(optarg); break;
+        case 'b': spin_idle_us = std::stoi(optarg); break;
+        case 'B': busy_usecs = std::stoi(optarg); break;
+        case 'm': limits.max_conns_per_ip = std::stoul(optarg); break;
+        case 'a': limits.conn_rate = std::stod(optarg); break;
+        case 'r': limits.req_rate = std::stod(optarg); break;
+        case 'o': overload = std::string(optarg) == "reject" ? overload_reject : overload_pause; break;
+        case 'w': capture.reset(new CaptureWriter(optarg)); break;  // 录制TCP/Unix域流量，供replay回放
+        case 'T': trace_path = optarg; break;  // 开启事件循环跟踪，SIGUSR1时导出
+        case 'e': persistent_out = true; break;
+        case 'S': syscall_report_s = std::stoi(optarg); break;
+        case 'H': http_mode = true; break;  // TCP/Unix域连接改用HTTP/1.1，UDP仍为计算器协议
+        case 'F': leader_follower = true; break;  // 连接不固定在某个工作线程，任一空闲线程处理就绪连接
+        case 'L': balancer.reset(new LoopBalancer(std::stoi(optarg))); break;  // 每隔若干毫秒检查负载并迁移连接
+        default:
+            std::cerr << "Usage: " << argv[0]
+                      << " [-u unix_path] [-s seqpacket_path] [-M shm_path] [-c max_conns]"
+                      << " [-b spin_idle_us] [-B busy_poll_us]"
+                      << " [-m conns_per_ip] [-a accepts_per_sec_per_ip] [-r requests_per_sec_per_ip]"
+                      << " [-o pause|reject] [-w capture_file] [-T trace_file] [-L balance_ms] [-e] [-S report_sec] [-H] [-F] [port]" << std::endl;
+            return 1;
+        }
+    }
+    if (busy_usecs && !spin_idle_us) spin_idle_us = default_spin_idle_us;
+    SockOpts opts;
+    opts.busy_poll = busy_usecs;
+    if (optind < argc) port = std::stoi(argv[optind]);
+    if (limits.max_conns_per_ip || limits.conn_rate > 0 || limits.req_rate > 0)
+        admission.reset(new AdmissionControl(limits));
+
+    if (max_conns) {
+        // 每个连接一个fd，另留出监听、epoll等余量
+        rlim_t limit = RaiseFdLimit(max_conns + 1024);
+        lg(Info, "massive connection mode, max conns: %lu, fd limit: %lu", max_conns, limit);
+    }
+
+    if (!trace_path.empty()) {
+        // 须在创建线程之前屏蔽SIGUSR1，由专门的线程接收后导出
+        Tracer::Instance().Enable();
+        Tracer::Instance().DumpOnSignal(SIGUSR1, trace_path);
+        lg(Info, "event loop tracing enabled, kill -USR1 %d to dump %s", getpid(), trace_path.c_str());
     }
 
-    // 创建环形队列
-    std::shared_ptr<RingQueue<ClientInf>> rq(new RingQueue<ClientInf>);
+    // 创建环形队列，入队时唤醒一个空闲工作线程
+    std::shared_ptr<RingQueue<ClientInf>> rq(
+        new RingQueue<ClientInf>(max_conns ? massive_queue_cap : default_queue_cap));
+    rq->EnableNotify();
     
+    if (leader_follower && (http_mode || balancer || capture || persistent_out || spin_idle_us || syscall_report_s)) {
+        lg(Warning, "leader/follower mode serves the calculator protocol only, -H/-L/-w/-e/-b/-S ignored");
+        http_mode = false;  // 监听线程的过载拒绝消息按计算器协议编码
+        balancer.reset();
+    }
+
     // 启动监听线程
-    std::thread base_thread(ListenHandler, rq, port);
+    std::thread base_thread(ListenHandler, rq, port, unix_path, seqpacket_path, shm_path, opts);
+
+    if (leader_follower) {
+        // 所有工作线程等待同一个epoll，连接以EPOLLONESHOT注册，处理完后重新布防
+        LeaderFollowerPool<CalcHandler, CalcCodec> pool(rq);
+        pool.SetAdmission(admission);
+        pool.Start(default_thread_num);
+        std::thread udp_thread(DatagramThread, port);  // UDP不依赖流式连接的线程模型
+        lg(Info, "leader/follower mode, %lu threads share one epoll, udp served by one thread", default_thread_num);
+        pool.Join();
+        udp_thread.join();
+        base_thread.join();
+        return 0;
+    }
     
     // 创建工作线程池
     std::vector<std::thread> threads;
     for (int i = 0; i < default_thread_num; ++i) {
-        threads.emplace_back(std::thread(EventHandler, rq));
+        threads.emplace_back(std::thread(EventHandler, rq, port, max_conns / default_thread_num,
+                                         spin_idle_us, busy_usecs));
     }
     
     // 等待所有线程结束
@@ -2,6 +2,13 @@
 #define _PROTOCOL_HPP_ 1
 
 #include <iostream>
+#include <vector>
+#include <cstring>
+#include <charconv>
+#include <string_view>
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
 
 // 协议分隔符定义
 const std::string blank_space_sep = " ";  // 字段间分隔符（空格）
@@ -11,6 +18,7 @@ const std::string protocol_sep = "\n";    // 协议分隔符（换行）
 enum {
     divide_by_zero_error = 1,  // 除零错误
     operator_identify,         // 操作符识别错误
+    server_busy,               // 服务器过载，连接被拒绝
 };
 
 // 协议解码函数
@@ -18,18 +26,27 @@ enum {
 // 参数: package - 输入的网络数据包
 //       content - 输出的解码后内容
 // 返回值: 解码成功返回true，失败返回false
-bool Decode(std::string &package, std::string &content)
+// content可为std::string或std::pmr::string（如事件循环竞技场上的临时对象）
+template<typename Buffer, typename String>
+bool Decode(Buffer &package, String &content)
 {
     // 查找第一个分隔符位置
     size_t pos = package.find(protocol_sep);
     if(pos == std::string::npos) return false;
     
     // 获取内容长度
-    size_t size = std::stoi(package.substr(0, pos));
+    size_t size = 0;
+    auto [end, ec] = std::from_chars(package.data(), package.data() + pos, size);
+    if(ec != std::errc() || end != package.data() + pos) {
+        package.clear();  // 长度字段非法，清空数据包
+        return false;
+    }
+    
+    size_t total_len = pos + size + 2;  // 计算完整消息长度
+    if(package.size() < total_len) return false;  // 帧未收全，等待后续数据
     
     // 查找第二个分隔符位置
     size_t n_pos = package.find(protocol_sep, pos + 1);
-    size_t total_len = pos + size + 2;  // 计算完整消息长度
     
     // 验证消息格式是否正确
     if(n_pos + 1 != total_len) {
@@ -39,13 +56,169 @@ bool Decode(std::string &package, std::string &content)
     }
     
     // 提取消息内容
-    content = package.substr(pos + 1, size);
+    content.assign(package.data() + pos + 1, size);
     
     // 删除已处理的部分
     package.erase(0, total_len);
     return true;
 }
 
+// 分隔符扫描函数类型：记录data[begin, end)中所有分隔符的位置
+using sep_scanner_t = void (*)(const char *data, size_t begin, size_t end, std::vector<size_t> &out);
+
+// 标量扫描
+void ScanSepScalar(const char *data, size_t begin, size_t end, std::vector<size_t> &out)
+{
+    const char *p = data + begin;
+    const char *last = data + end;
+    while(p < last && (p = (const char *)memchr(p, protocol_sep[0], last - p)) != nullptr)
+    {
+        out.push_back(p - data);
+        ++p;
+    }
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+// SSE2扫描：每16字节比较一次，按位掩码逐个取出分隔符位置
+void ScanSepSse2(const char *data, size_t begin, size_t end, std::vector<size_t> &out)
+{
+    const __m128i sep = _mm_set1_epi8(protocol_sep[0]);
+    size_t i = begin;
+    for(; i + 16 <= end; i += 16)
+    {
+        __m128i chunk = _mm_loadu_si128((const __m128i *)(data + i));
+        unsigned mask = _mm_movemask_epi8(_mm_cmpeq_epi8(chunk, sep));
+        while(mask)
+        {
+            out.push_back(i + __builtin_ctz(mask));
+            mask &= mask - 1;
+        }
+    }
+    ScanSepScalar(data, i, end, out);
+}
+
+// AVX2扫描：每32字节一次
+__attribute__((target("avx2")))
+void ScanSepAvx2(const char *data, size_t begin, size_t end, std::vector<size_t> &out)
+{
+    const __m256i sep = _mm256_set1_epi8(protocol_sep[0]);
+    size_t i = begin;
+    for(; i + 32 <= end; i += 32)
+    {
+        __m256i chunk = _mm256_loadu_si256((const __m256i *)(data + i));
+        unsigned mask = _mm256_movemask_epi8(_mm256_cmpeq_epi8(chunk, sep));
+        while(mask)
+        {
+            out.push_back(i + __builtin_ctz(mask));
+            mask &= mask - 1;
+        }
+    }
+    ScanSepScalar(data, i, end, out);
+}
+#endif
+
+// 运行时按CPU特性选择扫描函数
+sep_scanner_t SelectSepScanner()
+{
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_cpu_init();
+    if(__builtin_cpu_supports("avx2")) return ScanSepAvx2;
+    return ScanSepSse2;
+#else
+    return ScanSepScalar;
+#endif
+}
+
+inline const sep_scanner_t scan_sep = SelectSepScanner();
+
+/**
+ * @brief 帧索引：增量扫描输入缓冲区中的分隔符，按索引逐帧取出
+ * @note 新到达的数据只扫描一次，帧未收全时不会从头重新查找；
+ *       已取出的帧不立即删除，由Compact统一移出缓冲区。
+ *       两次调用之间缓冲区只能在尾部追加，其他方式修改后须调用Reset
+ */
+class FrameIndex{
+public:
+    // 取出下一个完整帧
+    // 参数: package - 输入缓冲区
+    //       content - 输出的帧内容
+    // 返回值: 取到完整帧返回true；数据不完整或格式错误（此时清空缓冲区，与Decode一致）返回false
+    template<typename Buffer, typename String>
+    bool Next(Buffer &package, String &content)
+    {
+        if(scanned_ < package.size())
+        {
+            scan_sep(package.data(), scanned_, package.size(), seps_);
+            scanned_ = package.size();
+        }
+        if(head_ >= seps_.size()) return false;
+
+        // 长度字段位于上一帧末尾到第一个分隔符之间
+        size_t pos = seps_[head_];
+        size_t size = 0;
+        auto [end, ec] = std::from_chars(package.data() + consumed_, package.data() + pos, size);
+        if(ec != std::errc() || end != package.data() + pos) return Discard(package);
+
+        size_t last = pos + size + 1;  // 结束分隔符位置
+        if(last >= package.size()) return false;  // 帧未收全
+        // 内容中不允许出现分隔符：下一个分隔符必须正好是结束分隔符
+        if(head_ + 1 >= seps_.size() || seps_[head_ + 1] != last) return Discard(package);
+
+        content.assign(package.data() + pos + 1, size);
+        consumed_ = last + 1;
+        head_ += 2;
+        return true;
+    }
+
+    // 将已取出的帧移出缓冲区，剩余分隔符位置随之平移
+    template<typename Buffer>
+    void Compact(Buffer &package)
+    {
+        if(consumed_ == 0) return;
+        package.erase(0, consumed_);
+        size_t remain = seps_.size() - head_;
+        for(size_t i = 0; i < remain; ++i)
+            seps_[i] = seps_[head_ + i] - consumed_;
+        seps_.resize(remain);
+        head_ = 0;
+        scanned_ -= consumed_;
+        consumed_ = 0;
+    }
+
+    // 缓冲区被外部修改后重建索引
+    void Reset()
+    {
+        seps_.clear();
+        head_ = 0;
+        consumed_ = 0;
+        scanned_ = 0;
+    }
+
+    // 缓冲区已清空时释放索引占用的内存
+    void Release()
+    {
+        if(seps_.empty() && seps_.capacity() > 0) std::vector<size_t>().swap(seps_);
+    }
+
+    // 已取出但尚未移出缓冲区的字节数
+    size_t Consumed() const { return consumed_; }
+
+private:
+    // 格式错误：丢弃缓冲区全部数据
+    template<typename Buffer>
+    bool Discard(Buffer &package)
+    {
+        package.clear();
+        Reset();
+        return false;
+    }
+
+    std::vector<size_t> seps_;  // 已扫描到的分隔符位置（相对缓冲区起始）
+    size_t head_ = 0;           // seps_中第一个属于未取出数据的下标
+    size_t consumed_ = 0;       // 已取出的字节数
+    size_t scanned_ = 0;        // 已扫描的字节数
+};
+
 // 协议编码函数
 // 格式: "长度\n内容\n"
 // 参数: content - 要编码的内容
@@ -59,6 +232,42 @@ std::string Encode(std::string &content)
     return ret;
 }
 
+// 原地编码函数：直接在out尾部写出"长度\n内容\n"，不产生临时字符串
+// 参数: out - 输出缓冲区，帧追加在其尾部
+//       max_content - 内容最大长度，用于预留空间和长度字段宽度
+//       write - 内容写入函数，签名 char *(char *first, char *last)，返回写入结束位置
+// 长度字段先按最大宽度预留，内容写完后回填；实际宽度较小时内容前移对齐
+template<typename String, typename Writer>
+void EncodeTo(String &out, size_t max_content, Writer write)
+{
+    char digits[24];
+    size_t width = std::to_chars(digits, digits + sizeof(digits), max_content).ptr - digits;
+
+    size_t start = out.size();
+    out.resize(start + width + max_content + 2);
+    char *base = out.data() + start;
+    char *first = base + width + 1;
+    char *last = write(first, first + max_content);
+    size_t size = last - first;
+
+    // 回填长度字段
+    size_t len = std::to_chars(digits, digits + sizeof(digits), size).ptr - digits;
+    if(len < width) memmove(base + len + 1, first, size);
+    memcpy(base, digits, len);
+    base[len] = protocol_sep[0];
+    base[len + 1 + size] = protocol_sep[0];
+    out.resize(start + len + size + 2);
+}
+
+// 解析十进制整数，允许前导'+'与尾随字符（与std::stoi一致），溢出或无数字时返回false
+bool ParseInt(std::string_view in, int &value)
+{
+    const char *first = in.data();
+    const char *last = first + in.size();
+    if(first != last && *first == '+') ++first;
+    return std::from_chars(first, last, value).ec == std::errc();
+}
+
 // 请求类（客户端→服务端）
 class Request{
 public:
@@ -79,31 +288,45 @@ public:
         ret += std::to_string(y_);
         return ret;
     }
+
+    // 序列化并编码为完整帧，直接追加到out（与Encode(Serialize())结果相同）
+    template<typename String>
+    void SerializeTo(String &out) const
+    {
+        EncodeTo(out, max_size, [this](char *first, char *last) {
+            first = std::to_chars(first, last, x_).ptr;
+            *first++ = blank_space_sep[0];
+            *first++ = op_;
+            *first++ = blank_space_sep[0];
+            return std::to_chars(first, last, y_).ptr;
+        });
+    }
     
     // 反序列化方法：从字符串解析对象
     // 参数: in - 输入字符串（格式必须为 "x op y"）
     // 返回值: 解析成功返回true，失败返回false
-    bool Deserialize(std::string &in)
+    // 直接在输入上解析，不产生子串
+    bool Deserialize(std::string_view in)
     {
         // 查找第一个空格位置
-        size_t pos = in.find(blank_space_sep);
-        if(pos == std::string::npos) return false;
+        size_t pos = in.find(blank_space_sep[0]);
+        if(pos == std::string_view::npos) return false;
         
         // 解析第一个操作数
-        x_ = std::stoi(in.substr(0, pos));
+        if(!ParseInt(in.substr(0, pos), x_)) return false;
         
         // 查找第二个空格位置
-        size_t npos = in.find(blank_space_sep, pos + 1);
-        if(npos == std::string::npos) return false;
+        size_t npos = in.find(blank_space_sep[0], pos + 1);
+        if(npos == std::string_view::npos) return false;
         
         // 解析操作符
         op_ = in[pos + 1];
         
         // 解析第二个操作数
-        y_ = std::stoi(in.substr(npos + 1));
-        return true;
+        return ParseInt(in.substr(npos + 1), y_);
     }
 public:
+    static constexpr size_t max_size = 11 + 3 + 11;  // 内容最大长度："-2147483648 + -2147483648"
     int x_;     // 第一个操作数
     int y_;     // 第二个操作数
     char op_;   // 操作符（+,-,*,/等）
@@ -126,26 +349,81 @@ public:
         ret += std::to_string(code_);
         return ret;
     }
+
+    // 序列化并编码为完整帧，直接追加到out（与Encode(Serialize())结果相同）
+    template<typename String>
+    void SerializeTo(String &out) const
+    {
+        EncodeTo(out, max_size, [this](char *first, char *last) {
+            first = std::to_chars(first, last, res_).ptr;
+            *first++ = blank_space_sep[0];
+            return std::to_chars(first, last, code_).ptr;
+        });
+    }
     
     // 反序列化方法：从字符串解析对象
     // 参数: in - 输入字符串（格式必须为 "result code"）
     // 返回值: 解析成功返回true，失败返回false
-    bool Deserialize(std::string &in)
+    bool Deserialize(std::string_view in)
     {
         // 查找空格位置
-        size_t pos = in.find(blank_space_sep);
-        if(pos == std::string::npos) return false;
+        size_t pos = in.find(blank_space_sep[0]);
+        if(pos == std::string_view::npos) return false;
         
         // 解析计算结果
-        res_ = std::stoi(in.substr(0, pos));
+        if(!ParseInt(in.substr(0, pos), res_)) return false;
         
         // 解析状态码
-        code_ = std::stoi(in.substr(pos + 1));
-        return true;
+        return ParseInt(in.substr(pos + 1), code_);
     }
 public:
+    static constexpr size_t max_size = 11 + 1 + 11;  // 内容最大长度："-2147483648 -2147483648"
     int res_;    // 计算结果
     int code_;   // 状态码（0表示成功，非0表示错误）
 };
 
+/**
+ * @brief 计算器协议的编解码器（供StaticEventLoop以模板参数使用）
+ * @note 解码沿连接的帧索引逐帧取出请求，格式错误的帧跳过不回复；
+ *       一轮解码结束后调用Consume把已取出的帧一次性移出缓冲区
+ */
+class CalcCodec{
+public:
+    using request_t = Request;
+    using response_t = Response;
+    using state_t = FrameIndex;  // 每个连接的解码状态
+
+    // 取出下一个完整请求，没有完整帧时返回false
+    template<typename Buffer>
+    bool Decode(Buffer &package, state_t &frames, request_t &req)
+    {
+        while(frames.Next(package, content_))
+            if(req.Deserialize(content_)) return true;
+        return false;
+    }
+
+    // 已解码的帧移出缓冲区
+    template<typename Buffer>
+    void Consume(Buffer &package, state_t &frames)
+    {
+        frames.Compact(package);
+    }
+
+    // 响应编码后追加到out
+    template<typename String>
+    void Encode(const response_t &resp, String &out)
+    {
+        resp.SerializeTo(out);
+    }
+
+    // 缓冲区已清空时释放解码状态占用的内存
+    void Release(state_t &frames)
+    {
+        frames.Release();
+    }
+
+private:
+    std::string content_;  // 帧内容（跨调用复用容量）
+};
+
 #endif
\ No newline at end of file
@@ -0,0 +1,447 @@
+#include <iostream>
+#include <string>
+#include <vector>
+#include <deque>
+#include <unordered_map>
+#include <algorithm>
+#include <fstream>
+#include <chrono>
+#include <cerrno>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <jsoncpp/json/json.h>
+#include "log.hpp"
+#include "epoll.hpp"
+#include "protocol.hpp"
+#include "capture.hpp"
+
+/**
+ * 流量回放工具：按录制文件（main.o -w）重放各连接的字节流，统计吞吐与延迟
+ * 用法: ./replay.o [-f] [-x 倍速] [-r] [-t 收尾超时] [-o 输出文件] [-b 基线文件] capture_file server_ip|unix_path [server_port]
+ *   -f  尽快回放：忽略录制时间，所有记录按顺序立即发出
+ *   -x  按录制节奏回放时的倍速（默认1）
+ *   -r  原始字节流模式：不按"长度\n内容\n"分帧，以每块数据到其后首个回包的时间作为延迟
+ *   -t  最后一条记录之后等待未完成响应的最长时间（毫秒，默认5000）
+ *   -o  JSON结果写入文件（默认标准输出）
+ *   -b  与之前保存的JSON结果对比吞吐与延迟
+ * 延迟从请求按录制节奏应发出的时刻算起，服务端变慢时排队等待的时间也计入
+ */
+
+const int default_drain_ms = 5000;  // 默认收尾超时（毫秒）
+const int replay_batch = 256;       // 单次epoll_wait事件数
+
+using replay_clock = std::chrono::steady_clock;
+
+static int64_t NowNs()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(replay_clock::now().time_since_epoch()).count();
+}
+
+// 回放中的一个连接
+struct ReplayConn
+{
+    int fd = -1;
+    bool connected = false;        // 非阻塞connect已完成
+    bool closing = false;          // 录制中已关闭，收齐响应后半关闭并等待对端关闭
+    std::string out;               // 待发送的数据
+    std::string requests;          // 尚未凑成完整帧的请求数据（分帧模式）
+    std::string responses;         // 尚未凑成完整帧的响应数据（分帧模式）
+    std::deque<int64_t> inflight;  // 等待响应的请求的计划发送时间
+};
+
+class Replayer
+{
+public:
+    Replayer(const struct sockaddr_storage &server, socklen_t len, bool fast, double speed, bool raw)
+        : server_(server), server_len_(len), fast_(fast), speed_(speed), raw_(raw) {}
+
+    /// 回放全部记录，drain_ms为最后一条记录之后等待响应的最长时间
+    void Run(const std::vector<CaptureEvent> &events, int drain_ms)
+    {
+        std::vector<struct epoll_event> ready(replay_batch);
+        start_ = NowNs();
+        last_ = start_;
+        size_t next = 0;
+        int64_t deadline = 0;
+        while (true)
+        {
+            int64_t now = NowNs();
+            while (next < events.size())
+            {
+                const CaptureEvent &ev = events[next];
+                int64_t due = fast_ ? now : start_ + (int64_t)(ev.ts_us * 1000 / speed_);
+                if (due > now) break;
+                Apply(ev, due);
+                ++next;
+            }
+
+            int timeout;
+            if (next < events.size())
+            {
+                int64_t due = start_ + (int64_t)(events[next].ts_us * 1000 / speed_);
+                timeout = fast_ ? 0 : (int)std::max<int64_t>(0, (due - now + 999999) / 1000000);
+            }
+            else
+            {
+                if (outstanding_ == 0 && closing_ == 0) break;
+                if (deadline == 0) deadline = now + (int64_t)drain_ms * 1000000;
+                if (now >= deadline)
+                {
+                    lg(Warning, "replay drain timeout, %lu requests unanswered", outstanding_);
+                    break;
+                }
+                timeout = (int)((deadline - now + 999999) / 1000000);
+            }
+
+            int n = epoller_.EpollWait(ready.data(), ready.size(), timeout);
+            for (int i = 0; i < n; ++i)
+            {
+                auto iter = by_fd_.find(ready[i].data.fd);
+                if (iter == by_fd_.end()) continue;
+                uint32_t id = iter->second;
+                if (ready[i].events & (EPOLLOUT | EPOLLERR | EPOLLHUP)) OnWritable(id);
+                if (by_fd_.count(ready[i].data.fd) && ready[i].events & (EPOLLIN | EPOLLERR | EPOLLHUP)) OnReadable(id);
+            }
+        }
+        // 收尾超时：仍未收到的响应计为丢失
+        for (auto &[id, conn] : conns_)
+        {
+            lost_ += conn.inflight.size();
+            if (conn.fd >= 0) close(conn.fd);
+        }
+        conns_.clear();
+        by_fd_.clear();
+    }
+
+    /// 回放结果
+    Json::Value Result()
+    {
+        double seconds = (last_ - start_) / 1e9;
+        Json::Value root;
+        root["mode"] = fast_ ? "fast" : "paced";
+        root["speed"] = speed_;
+        root["framing"] = raw_ ? "raw" : "frame";
+        root["connections"] = (Json::UInt64)connections_;
+        root["connect_errors"] = (Json::UInt64)connect_errors_;
+        root["requests"] = (Json::UInt64)requests_;
+        root["responses"] = (Json::UInt64)latencies_.size();
+        root["lost"] = (Json::UInt64)lost_;
+        root["bytes_out"] = (Json::UInt64)bytes_out_;
+        root["bytes_in"] = (Json::UInt64)bytes_in_;
+        root["seconds"] = seconds;
+        root["requests_per_sec"] = seconds > 0 ? latencies_.size() / seconds : 0.0;
+
+        std::sort(latencies_.begin(), latencies_.end());
+        Json::Value lat;
+        double sum = 0;
+        for (int64_t v : latencies_) sum += v;
+        lat["mean"] = latencies_.empty() ? 0.0 : sum / latencies_.size() / 1000;
+        for (auto [name, q] : {std::pair<const char *, double>{"p50", 0.5}, {"p90", 0.9}, {"p99", 0.99}, {"p999", 0.999}})
+            lat[name] = latencies_.empty() ? 0.0 : latencies_[(size_t)(q * (latencies_.size() - 1))] / 1000.0;
+        lat["max"] = latencies_.empty() ? 0.0 : latencies_.back() / 1000.0;
+        root["latency_us"] = lat;
+        return root;
+    }
+
+private:
+    void Apply(const CaptureEvent &ev, int64_t due)
+    {
+        if (ev.type == capture_connect)
+        {
+            Open(ev.conn);
+            return;
+        }
+        auto iter = conns_.find(ev.conn);
+        if (iter == conns_.end()) return;  // 连接失败或录制开始前已存在的连接
+        ReplayConn &conn = iter->second;
+        if (ev.type == capture_data)
+        {
+            conn.out += ev.data;
+            if (raw_)
+            {
+                conn.inflight.push_back(due);
+                ++requests_;
+                ++outstanding_;
+            }
+            else
+            {
+                conn.requests += ev.data;
+                std::string content;
+                while (Decode(conn.requests, content))
+                {
+                    conn.inflight.push_back(due);
+                    ++requests_;
+                    ++outstanding_;
+                }
+            }
+        }
+        else if (!conn.closing)
+        {
+            conn.closing = true;
+            ++closing_;
+        }
+        if (conn.connected) Flush(ev.conn, conn);
+    }
+
+    void Open(uint32_t id)
+    {
+        int fd = socket(server_.ss_family, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        if (fd == -1)
+        {
+            lg(Error, "socket false, errno: %d, errstr: %s", errno, strerror(errno));
+            ++connect_errors_;
+            return;
+        }
+        if (connect(fd, (struct sockaddr *)&server_, server_len_) == -1 && errno != EINPROGRESS)
+        {
+            lg(Warning, "connect false, errno: %d, errstr: %s", errno, strerror(errno));
+            close(fd);
+            ++connect_errors_;
+            return;
+        }
+        ReplayConn &conn = conns_[id];
+        conn.fd = fd;
+        by_fd_[fd] = id;
+        ++connections_;
+        epoller_.EpollCtl(EPOLL_CTL_ADD, fd, EPOLLIN | EPOLLOUT | EPOLLET);
+    }
+
+    void OnWritable(uint32_t id)
+    {
+        ReplayConn &conn = conns_[id];
+        if (!conn.connected)
+        {
+            int err = 0;
+            socklen_t len = sizeof(err);
+            getsockopt(conn.fd, SOL_SOCKET, SO_ERROR, &err, &len);
+            if (err != 0)
+            {
+                lg(Warning, "connect false, errno: %d, errstr: %s", err, strerror(err));
+                ++connect_errors_;
+                Drop(id, conn);
+                return;
+            }
+            conn.connected = true;
+        }
+        Flush(id, conn);
+    }
+
+    // 录制中已关闭的连接在数据发完、响应收齐后半关闭写端
+    // （服务端与FIN同批到达的数据不再处理，提前半关闭会丢掉最后的请求）
+    void MaybeShutdown(ReplayConn &conn)
+    {
+        if (conn.closing && conn.out.empty() && conn.inflight.empty()) shutdown(conn.fd, SHUT_WR);
+    }
+
+    // 尽量发送待发数据
+    void Flush(uint32_t id, ReplayConn &conn)
+    {
+        size_t sent = 0;
+        while (sent < conn.out.size())
+        {
+            ssize_t n = send(conn.fd, conn.out.data() + sent, conn.out.size() - sent, MSG_NOSIGNAL);
+            if (n > 0) sent += n;
+            else if (n == -1 && errno == EINTR) continue;
+            else if (n == -1 && errno == EAGAIN) break;
+            else
+            {
+                Drop(id, conn);
+                return;
+            }
+        }
+        conn.out.erase(0, sent);
+        bytes_out_ += sent;
+        MaybeShutdown(conn);
+    }
+
+    void OnReadable(uint32_t id)
+    {
+        ReplayConn &conn = conns_[id];
+        char buf[65536];
+        while (true)
+        {
+            ssize_t n = recv(conn.fd, buf, sizeof(buf), 0);
+            if (n > 0)
+            {
+                int64_t now = NowNs();
+                last_ = now;
+                bytes_in_ += n;
+                if (raw_)
+                {
+                    // 原始模式：此前发出的数据块都视为得到响应
+                    for (int64_t sent : conn.inflight) latencies_.push_back(now - sent);
+                    outstanding_ -= conn.inflight.size();
+                    conn.inflight.clear();
+                    MaybeShutdown(conn);
+                    continue;
+                }
+                conn.responses.append(buf, n);
+                std::string content;
+                while (Decode(conn.responses, content) && !conn.inflight.empty())
+                {
+                    latencies_.push_back(now - conn.inflight.front());
+                    conn.inflight.pop_front();
+                    --outstanding_;
+                }
+                MaybeShutdown(conn);
+            }
+            else if (n == -1 && errno == EINTR) continue;
+            else if (n == -1 && errno == EAGAIN) return;
+            else
+            {
+                Drop(id, conn);  // 对端关闭或出错
+                return;
+            }
+        }
+    }
+
+    // 关闭连接，未得到响应的请求计为丢失
+    void Drop(uint32_t id, ReplayConn &conn)
+    {
+        lost_ += conn.inflight.size();
+        outstanding_ -= conn.inflight.size();
+        if (conn.closing) --closing_;
+        epoller_.EpollCtl(EPOLL_CTL_DEL, conn.fd, 0);
+        close(conn.fd);
+        by_fd_.erase(conn.fd);
+        conns_.erase(id);
+    }
+
+    struct sockaddr_storage server_;
+    socklen_t server_len_;
+    bool fast_;
+    double speed_;
+    bool raw_;
+    Epoll epoller_;
+    std::unordered_map<uint32_t, ReplayConn> conns_; // 录制中的连接号 -> 回放连接
+    std::unordered_map<int, uint32_t> by_fd_;        // fd -> 录制中的连接号
+    std::vector<int64_t> latencies_;                 // 每个响应的延迟（纳秒）
+    int64_t start_ = 0;                              // 回放开始时间
+    int64_t last_ = 0;                               // 最后一次收到响应的时间
+    size_t outstanding_ = 0;                         // 等待响应的请求数
+    size_t closing_ = 0;                             // 等待对端关闭的连接数
+    uint64_t connections_ = 0, connect_errors_ = 0, requests_ = 0, lost_ = 0;
+    uint64_t bytes_out_ = 0, bytes_in_ = 0;
+};
+
+// 与基线结果逐项对比
+static void Compare(const Json::Value &base, const Json::Value &cur)
+{
+    auto line = [](const char *name, double b, double c) {
+        fprintf(stderr, "%-20s %14.1f %14.1f %+8.1f%%\n", name, b, c, b != 0 ? (c - b) / b * 100 : 0.0);
+    };
+    fprintf(stderr, "%-20s %14s %14s %9s\n", "metric", "baseline", "current", "change");
+    line("requests_per_sec", base["requests_per_sec"].asDouble(), cur["requests_per_sec"].asDouble());
+    for (const char *q : {"mean", "p50", "p90", "p99", "p999", "max"})
+        line((std::string("latency_us.") + q).c_str(), base["latency_us"][q].asDouble(), cur["latency_us"][q].asDouble());
+    line("lost", base["lost"].asDouble(), cur["lost"].asDouble());
+}
+
+static void Usage(const char *proc)
+{
+    std::cerr << "Usage: " << proc
+              << " [-f] [-x speed] [-r] [-t drain_ms] [-o output] [-b baseline]"
+              << " capture_file server_ip|unix_path [server_port]" << std::endl;
+}
+
+int main(int argc, char *argv[])
+{
+    bool fast = false, raw = false;
+    double speed = 1;
+    int drain_ms = default_drain_ms;
+    std::string output, baseline;
+    int opt;
+    while ((opt = getopt(argc, argv, "fx:rt:o:b:")) != -1)
+    {
+        switch (opt)
+        {
+        case 'f': fast = true; break;
+        case 'x': speed = std::stod(optarg); break;
+        case 'r': raw = true; break;
+        case 't': drain_ms = std::stoi(optarg); break;
+        case 'o': output = optarg; break;
+        case 'b': baseline = optarg; break;
+        default: Usage(argv[0]); return 1;
+        }
+    }
+    if (argc - optind < 2 || speed <= 0)
+    {
+        Usage(argv[0]);
+        return 1;
+    }
+    lg.Enable(Silent);
+
+    std::string path = argv[optind];
+    std::string target = argv[optind + 1];
+    struct sockaddr_storage server = {};
+    socklen_t len;
+    if (target[0] == '/')
+    {
+        // 同机Unix域stream socket
+        struct sockaddr_un *un = (struct sockaddr_un *)&server;
+        un->sun_family = AF_UNIX;
+        strncpy(un->sun_path, target.c_str(), sizeof(un->sun_path) - 1);
+        len = sizeof(struct sockaddr_un);
+    }
+    else
+    {
+        if (argc - optind < 3)
+        {
+            Usage(argv[0]);
+            return 1;
+        }
+        struct sockaddr_in *in = (struct sockaddr_in *)&server;
+        in->sin_family = AF_INET;
+        in->sin_port = htons(std::stoi(argv[optind + 2]));
+        if (inet_pton(AF_INET, target.c_str(), &in->sin_addr) != 1)
+        {
+            std::cerr << "bad server ip: " << target << std::endl;
+            return 1;
+        }
+        len = sizeof(struct sockaddr_in);
+    }
+
+    std::vector<CaptureEvent> events;
+    if (!LoadCapture(path, events))
+    {
+        std::cerr << "cannot load capture file: " << path << std::endl;
+        return 1;
+    }
+
+    Replayer replayer(server, len, fast, speed, raw);
+    replayer.Run(events, drain_ms);
+    Json::Value result = replayer.Result();
+    result["capture"] = path;
+    result["records"] = (Json::UInt64)events.size();
+    fprintf(stderr, "%lu requests, %lu responses, %lu lost, %.0f req/s, latency p50 %.1f us, p99 %.1f us\n",
+            (unsigned long)result["requests"].asUInt64(), (unsigned long)result["responses"].asUInt64(),
+            (unsigned long)result["lost"].asUInt64(), result["requests_per_sec"].asDouble(),
+            result["latency_us"]["p50"].asDouble(), result["latency_us"]["p99"].asDouble());
+
+    if (!baseline.empty())
+    {
+        std::ifstream in(baseline);
+        Json::Value base;
+        Json::CharReaderBuilder reader;
+        std::string errs;
+        if (in && Json::parseFromStream(reader, in, &base, &errs)) Compare(base, result);
+        else std::cerr << "cannot read baseline " << baseline << ": " << errs << std::endl;
+    }
+
+    Json::StreamWriterBuilder writer;
+    writer["indentation"] = "  ";
+    std::string json = Json::writeString(writer, result) + "\n";
+    if (output.empty())
+    {
+        fwrite(json.data(), 1, json.size(), stdout);
+    }
+    else
+    {
+        std::ofstream out(output);
+        out << json;
+    }
+    return 0;
+}
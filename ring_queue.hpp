@@ -6,6 +6,10 @@
 #include <vector>
 #include <semaphore.h>
 #include <optional>
+#include <atomic>
+#include <unistd.h>
+#include <sys/eventfd.h>
+#include "trace.hpp"
 
 /**
  * RAII风格的互斥锁保护类
@@ -64,11 +68,15 @@ public:
     :cap_(cap),
     c_index_(0),    // 消费者索引初始化为0
     p_index_(0),    // 生产者索引初始化为0
-    queue(cap)      // 初始化vector容量
+    queue(cap),     // 初始化vector容量
+    notify_fd_(-1),
+    full_(0),
+    space_wanted_(false)
     {
         // 初始化生产者和消费者互斥锁
         pthread_mutex_init(&p_mutex_, nullptr);
         pthread_mutex_init(&c_mutex_, nullptr);
+        pthread_mutex_init(&w_mutex_, nullptr);
         
         // 初始化空间信号量(初始值为容量大小)
         sem_init(&space_sem_, 0, cap_);
@@ -81,19 +89,38 @@ public:
     {
         pthread_mutex_destroy(&p_mutex_);
         pthread_mutex_destroy(&c_mutex_);
+        pthread_mutex_destroy(&w_mutex_);
         sem_destroy(&space_sem_);
         sem_destroy(&data_sem_);
+        if(notify_fd_ >= 0) close(notify_fd_);
     }
+
+    /**
+     * 开启入队通知：每次成功Push向eventfd计数加一
+     * 消费者把该fd注册到epoll，新元素到达时立即被唤醒，而不必等待epoll_wait超时
+     * @return 通知用eventfd（信号量语义，每次read取走一个计数）
+     */
+    int EnableNotify()
+    {
+        if(notify_fd_ < 0)
+            notify_fd_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC | EFD_SEMAPHORE);
+        return notify_fd_;
+    }
+
+    // 获取通知fd，未开启时为-1
+    int NotifyFd() { return notify_fd_; }
     
     /**
      * 向队列推送元素(生产者调用)
      * @param task 要添加的元素
+     * @return 队列已满返回false，元素未入队，由调用者决定如何处理
      */
-    void Push(const T & task)
+    bool Push(const T & task)
     {
         // 尝试获取空间信号量(非阻塞)
         if(P(space_sem_) == -1){
-            return;  // 获取失败直接返回
+            full_.fetch_add(1, std::memory_order_relaxed);
+            return false;
         }
         
         {
@@ -105,7 +132,40 @@ public:
         
         // 释放数据信号量(通知消费者有新数据)
         V(data_sem_);
+
+        if(notify_fd_ >= 0)
+        {
+            uint64_t one = 1;
+            write(notify_fd_, &one, sizeof(one));
+        }
+        return true;
+    }
+
+    /**
+     * 队列满后登记一个eventfd，之后第一次Pop腾出空间时向其写入（一次性）
+     * @param fd 由调用者创建和关闭的eventfd
+     * @return 登记时已有空间返回false（未登记，可直接重试Push）
+     */
+    bool WaitSpace(int fd)
+    {
+        {
+            LockGuard lg(w_mutex_);
+            space_waiters_.push_back(fd);
+            space_wanted_.store(true);
+        }
+        // 登记之前可能已有Pop腾出空间而没有看到标志，再检查一次
+        int space = 0;
+        sem_getvalue(&space_sem_, &space);
+        if(space > 0)
+        {
+            NotifySpace();
+            return false;
+        }
+        return true;
     }
+
+    /// 因队列满而入队失败的累计次数（可跨线程读取）
+    uint64_t FullCount() { return full_.load(std::memory_order_relaxed); }
     
     /**
      * 从队列弹出元素(消费者调用)
@@ -128,10 +188,22 @@ public:
         
         // 释放空间信号量(通知生产者有新空间)
         V(space_sem_);
+        if(space_wanted_.load()) NotifySpace();  // 唤醒因队列满而暂停的生产者
+        TraceInstant("queue_pop");
         return task;  // 返回获取的元素
     }
 
 private:
+    // 通知并清空所有等待空间的eventfd
+    void NotifySpace()
+    {
+        LockGuard lg(w_mutex_);
+        space_wanted_.store(false);
+        uint64_t one = 1;
+        for(int fd : space_waiters_) write(fd, &one, sizeof(one));
+        space_waiters_.clear();
+    }
+
     sem_t space_sem_;         // 空间信号量(剩余空间计数)
     sem_t data_sem_;          // 数据信号量(可用数据计数)
     pthread_mutex_t p_mutex_; // 生产者互斥锁
@@ -140,6 +212,11 @@ private:
     size_t c_index_;         // 消费者索引(读取位置)
     size_t p_index_;         // 生产者索引(写入位置)
     std::vector<T> queue;    // 底层存储容器
+    int notify_fd_;          // 入队通知eventfd（可选）
+    std::atomic<uint64_t> full_;       // 入队失败次数
+    std::atomic<bool> space_wanted_;   // 是否有生产者在等待空间
+    pthread_mutex_t w_mutex_;          // 保护space_waiters_
+    std::vector<int> space_waiters_;   // 等待空间的eventfd
 };
 
 #endif
\ No newline at end of file
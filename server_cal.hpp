@@ -2,7 +2,45 @@
 #define _SERVER_CAL_HPP_ 1;
 
 #include <iostream>
+#include <vector>
+#include <cstdint>
+#include <climits>
+#include <memory_resource>
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
 #include "protocol.hpp"  // 包含之前定义的自定义协议头文件
+#include "http.hpp"      // HTTP端点
+
+// 批量请求的列式存储：各列同一下标对应同一请求
+struct CalColumns
+{
+    std::vector<int32_t> x;    // 第一个操作数
+    std::vector<int32_t> y;    // 第二个操作数
+    std::vector<int32_t> op;   // 操作符（按字符值存放）
+    std::vector<int32_t> res;  // 计算结果
+    std::vector<int32_t> code; // 状态码
+
+    void Clear()
+    {
+        x.clear();
+        y.clear();
+        op.clear();
+    }
+
+    void Push(const Request &req)
+    {
+        x.push_back(req.x_);
+        y.push_back(req.y_);
+        op.push_back(req.op_);
+    }
+
+    size_t Size() const { return x.size(); }
+};
+
+// 列式求值内核：对n个请求计算res与code
+using cal_kernel_t = void (*)(const int32_t *x, const int32_t *y, const int32_t *op,
+                              int32_t *res, int32_t *code, size_t n);
 
 // 计算器服务端类
 class ServerCal
@@ -55,7 +93,8 @@ public:
     // 主计算函数，处理协议解码和编码
     // 参数: package - 网络接收到的原始数据包
     // 返回值: 编码后的响应字符串，出错返回空字符串
-    std::string Calculator(std::string &package)
+    template <typename Buffer>
+    std::string Calculator(Buffer &package)
     {
         std::string content;
         
@@ -80,6 +119,289 @@ public:
         return content;
     }
 
+    // 单帧计算函数，临时对象与返回值都分配在mr上（通常为EventLoop::CurrentArena()）
+    // 参数: package - 网络接收到的原始数据包
+    //       mr - 内存资源
+    // 返回值: 编码后的响应，出错返回空字符串
+    template <typename Buffer>
+    std::pmr::string Calculator(Buffer &package, std::pmr::memory_resource *mr)
+    {
+        std::pmr::string content(mr);
+        std::pmr::string out(mr);
+        if (!Decode(package, content)) return out;
+        
+        Request req;
+        if (!req.Deserialize(content)) return out;
+        
+        CalculatorHelper(req).SerializeTo(out);
+        return out;
+    }
+
+    // 批量计算函数，处理深度流水线
+    // 参数: package - 网络接收到的原始数据包（std::string或连接的buffer_t），所有完整帧被消费
+    //       out - 全部响应编码后追加到此处（可直接传入连接的Connection::OutTail()）
+    //       frames - package的帧索引，跨多次调用保留未收全帧的扫描结果
+    //       admit - 解码后、求值前以请求数n调用，返回放行的请求数（只计算并回复前这么多个）
+    // 返回值: 本次处理的请求数
+    template <typename Buffer, typename Out, typename Admit>
+    size_t CalculatorBatch(Buffer &package, Out &out, FrameIndex &frames, Admit &&admit)
+    {
+        // 1. 沿帧索引解码全部完整帧，按列存放（列缓冲区线程内复用）
+        CalColumns &cols = columns_;
+        cols.Clear();
+        std::string content;
+        Request req;
+        while (frames.Next(package, content))
+        {
+            if (!req.Deserialize(content)) continue;  // 格式错误的帧不回复
+            cols.Push(req);
+        }
+        frames.Compact(package);  // 已解码的帧一次性删除
+        size_t n = cols.Size();
+        if (n == 0) return 0;
+        n = std::min(n, (size_t)admit(n));  // 超出准入的请求不求值
+        if (n == 0) return 0;
+
+        // 2. 向量化求值
+        cols.res.resize(n);
+        cols.code.resize(n);
+        eval_kernel_(cols.x.data(), cols.y.data(), cols.op.data(), cols.res.data(), cols.code.data(), n);
+
+        // 3. 一次性编码全部响应，直接写入out
+        out.reserve(out.size() + n * (Response::max_size + 4));
+        for (size_t i = 0; i < n; ++i)
+            Response(cols.res[i], cols.code[i]).SerializeTo(out);
+        return n;
+    }
+
+    template <typename Buffer, typename Out>
+    size_t CalculatorBatch(Buffer &package, Out &out, FrameIndex &frames)
+    {
+        return CalculatorBatch(package, out, frames, [](size_t n) { return n; });
+    }
+
+    // 无需跨调用保留索引时使用（如一次收全的数据报）
+    template <typename Buffer, typename Out>
+    size_t CalculatorBatch(Buffer &package, Out &out)
+    {
+        FrameIndex frames;
+        return CalculatorBatch(package, out, frames);
+    }
+
+    // HTTP计算函数，处理keep-alive连接上的流水线请求
+    // 端点: GET /calc?x=10&op=add&y=20，或POST /calc且请求体为"10 + 20"
+    //       op可为add/sub/mul/div/mod或百分号编码的运算符（如%2B）
+    // 参数: package - 输入缓冲区，所有完整请求被消费
+    //       out - 响应追加到此处，正文为"result code"
+    //       parser - package的HTTP解析器
+    //       close - 置为true表示最后一个响应后应关闭连接（客户端要求、请求格式错误或准入拒绝），其后的输入被丢弃
+    //       admit - 每解析出一个请求、求值前以1调用，返回0表示拒绝：不再回复该请求及其后的请求
+    // 返回值: 本次回复的请求数
+    template <typename Buffer, typename Out, typename Admit>
+    size_t CalculatorHttp(Buffer &package, Out &out, HttpParser &parser, bool &close, Admit &&admit)
+    {
+        HttpRequest req;
+        HttpParseStatus status;
+        size_t n = 0;
+        close = false;
+        while ((status = parser.Next(package, req)) == http_complete)
+        {
+            if (admit((size_t)1) == 0)
+            {
+                close = true;
+                break;
+            }
+            ++n;
+            Request calc;
+            int code = HttpToRequest(req, calc);
+            if (code == 200)
+            {
+                Response resp = CalculatorHelper(calc);
+                char body[Response::max_size + 1];
+                char *last = std::to_chars(body, body + sizeof(body), resp.res_).ptr;
+                *last++ = blank_space_sep[0];
+                last = std::to_chars(last, body + sizeof(body), resp.code_).ptr;
+                HttpWriteResponse(out, 200, std::string_view(body, last - body), req.keep_alive, req.minor_version);
+            }
+            else
+            {
+                HttpWriteResponse(out, code, HttpReason(code), req.keep_alive, req.minor_version);
+            }
+            if (!req.keep_alive)
+            {
+                close = true;
+                break;
+            }
+        }
+        if (status == http_error)  // 无法确定请求边界，回复后关闭
+        {
+            ++n;
+            HttpWriteResponse(out, req.error_status, HttpReason(req.error_status), false);
+            close = true;
+        }
+        if (close)
+        {
+            package.clear();
+            parser.Reset();
+        }
+        else
+        {
+            parser.Compact(package);
+        }
+        return n;
+    }
+
+    template <typename Buffer, typename Out>
+    size_t CalculatorHttp(Buffer &package, Out &out, HttpParser &parser, bool &close)
+    {
+        return CalculatorHttp(package, out, parser, close, [](size_t n) { return n; });
+    }
+
+    // 标量内核，结果与CalculatorHelper一致；溢出按补码回绕，INT_MIN / -1 得INT_MIN而不触发SIGFPE
+    static void EvalScalar(const int32_t *x, const int32_t *y, const int32_t *op,
+                           int32_t *res, int32_t *code, size_t n)
+    {
+        for (size_t i = 0; i < n; ++i)
+        {
+            uint32_t a = x[i], b = y[i];
+            int32_t r = 0, c = 0;
+            switch (op[i])
+            {
+            case '+': r = (int32_t)(a + b); break;
+            case '-': r = (int32_t)(a - b); break;
+            case '*': r = (int32_t)(a * b); break;
+            case '/':
+            case '%':
+                if (y[i] == 0)
+                    c = divide_by_zero_error;
+                else if (x[i] == INT_MIN && y[i] == -1)
+                    r = op[i] == '/' ? INT_MIN : 0;
+                else
+                    r = op[i] == '/' ? x[i] / y[i] : x[i] % y[i];
+                break;
+            default:
+                c = operator_identify;
+                break;
+            }
+            res[i] = r;
+            code[i] = c;
+        }
+    }
+
+#if defined(__x86_64__) || defined(__i386__)
+    // AVX2内核：每次8个请求，五种运算全部计算后按操作符掩码选择；
+    // 整数除法经double完成（int32的商在double中精确，截断即得C语义结果），
+    // 除数为0的通道以1代替再屏蔽结果并置错误码
+    __attribute__((target("avx2")))
+    static void EvalAvx2(const int32_t *x, const int32_t *y, const int32_t *op,
+                         int32_t *res, int32_t *code, size_t n)
+    {
+        const __m256i zero = _mm256_setzero_si256();
+        const __m256i one = _mm256_set1_epi32(1);
+        const __m256i op_add = _mm256_set1_epi32('+');
+        const __m256i op_sub = _mm256_set1_epi32('-');
+        const __m256i op_mul = _mm256_set1_epi32('*');
+        const __m256i op_div = _mm256_set1_epi32('/');
+        const __m256i op_mod = _mm256_set1_epi32('%');
+        const __m256i div_zero = _mm256_set1_epi32(divide_by_zero_error);
+        const __m256i bad_op = _mm256_set1_epi32(operator_identify);
+
+        size_t i = 0;
+        for (; i + 8 <= n; i += 8)
+        {
+            __m256i a = _mm256_loadu_si256((const __m256i *)(x + i));
+            __m256i b = _mm256_loadu_si256((const __m256i *)(y + i));
+            __m256i o = _mm256_loadu_si256((const __m256i *)(op + i));
+
+            __m256i is_add = _mm256_cmpeq_epi32(o, op_add);
+            __m256i is_sub = _mm256_cmpeq_epi32(o, op_sub);
+            __m256i is_mul = _mm256_cmpeq_epi32(o, op_mul);
+            __m256i is_div = _mm256_cmpeq_epi32(o, op_div);
+            __m256i is_mod = _mm256_cmpeq_epi32(o, op_mod);
+            __m256i b_zero = _mm256_cmpeq_epi32(b, zero);
+
+            __m256i safe_b = _mm256_blendv_epi8(b, one, b_zero);
+            __m256d q_lo = _mm256_div_pd(_mm256_cvtepi32_pd(_mm256_castsi256_si128(a)),
+                                         _mm256_cvtepi32_pd(_mm256_castsi256_si128(safe_b)));
+            __m256d q_hi = _mm256_div_pd(_mm256_cvtepi32_pd(_mm256_extracti128_si256(a, 1)),
+                                         _mm256_cvtepi32_pd(_mm256_extracti128_si256(safe_b, 1)));
+            // 越界（INT_MIN / -1）时cvttpd得0x80000000，与标量内核一致
+            __m256i q = _mm256_set_m128i(_mm256_cvttpd_epi32(q_hi), _mm256_cvttpd_epi32(q_lo));
+            __m256i m = _mm256_sub_epi32(a, _mm256_mullo_epi32(q, safe_b));
+
+            __m256i r = _mm256_and_si256(is_add, _mm256_add_epi32(a, b));
+            r = _mm256_or_si256(r, _mm256_and_si256(is_sub, _mm256_sub_epi32(a, b)));
+            r = _mm256_or_si256(r, _mm256_and_si256(is_mul, _mm256_mullo_epi32(a, b)));
+            __m256i dm = _mm256_or_si256(_mm256_and_si256(is_div, q), _mm256_and_si256(is_mod, m));
+            r = _mm256_or_si256(r, _mm256_andnot_si256(b_zero, dm));
+
+            __m256i is_dm = _mm256_or_si256(is_div, is_mod);
+            __m256i known = _mm256_or_si256(_mm256_or_si256(is_add, is_sub), _mm256_or_si256(is_mul, is_dm));
+            __m256i c = _mm256_and_si256(_mm256_and_si256(is_dm, b_zero), div_zero);
+            c = _mm256_or_si256(c, _mm256_andnot_si256(known, bad_op));
+
+            _mm256_storeu_si256((__m256i *)(res + i), r);
+            _mm256_storeu_si256((__m256i *)(code + i), c);
+        }
+        EvalScalar(x + i, y + i, op + i, res + i, code + i, n - i);  // 尾部不足8个
+    }
+#endif
+
+    // 当前CPU选用的内核名称
+    static const char *KernelName() { return eval_kernel_ == EvalScalar ? "scalar" : "avx2"; }
+
+private:
+    // 由HTTP请求得到计算请求，返回应回复的状态码
+    static int HttpToRequest(const HttpRequest &req, Request &calc)
+    {
+        if (req.path != "/calc") return 404;
+        if (req.method == "POST") return calc.Deserialize(req.body) ? 200 : 400;
+        if (req.method != "GET") return 405;
+
+        std::string_view x, y, op;
+        if (!req.Param("x", x) || !req.Param("y", y) || !req.Param("op", op)) return 400;
+        if (!ParseInt(x, calc.x_) || !ParseInt(y, calc.y_)) return 400;
+        calc.op_ = HttpOperator(op);
+        return 200;
+    }
+
+    // 查询串中的运算符：单个字符、%XX编码或英文名，无法识别时交给计算逻辑报告operator_identify
+    static char HttpOperator(std::string_view op)
+    {
+        if (op.size() == 1) return op[0];
+        if (op.size() == 3 && op[0] == '%')
+        {
+            int value = 0;
+            auto [end, ec] = std::from_chars(op.data() + 1, op.data() + 3, value, 16);
+            if (ec == std::errc() && end == op.data() + 3) return (char)value;
+        }
+        static const std::pair<std::string_view, char> names[] = {
+            {"add", '+'}, {"sub", '-'}, {"mul", '*'}, {"div", '/'}, {"mod", '%'}};
+        for (auto &[name, c] : names)
+            if (op == name) return c;
+        return '?';
+    }
+
+    // 运行时按CPU特性选择内核
+    static cal_kernel_t SelectKernel()
+    {
+#if defined(__x86_64__) || defined(__i386__)
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx2")) return EvalAvx2;
+#endif
+        return EvalScalar;
+    }
+
+    static inline const cal_kernel_t eval_kernel_ = SelectKernel();
+    static inline thread_local CalColumns columns_;  // 多个工作线程共用一个ServerCal
+};
+
+// 计算器请求处理器（供StaticEventLoop以模板参数使用，调用可内联进读路径）
+struct CalcHandler
+{
+    Response operator()(const Request &req) { return sc_.CalculatorHelper(req); }
+
+    ServerCal sc_;
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,429 @@
+#ifndef _SHM_RING_HPP_
+#define _SHM_RING_HPP_ 1
+
+#include <string>
+#include <memory>
+#include <atomic>
+#include <new>
+#include <algorithm>
+#include <cstring>
+#include <cstdint>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/eventfd.h>
+#include "log.hpp"
+#include "nocopy.hpp"
+
+inline const size_t default_shm_ring_bytes = 1 << 20; // 每个方向环形缓冲的默认容量（2的幂）
+inline const uint32_t shm_magic = 0x4d485352;         // "RSHM"
+inline const uint32_t shm_version = 1;
+inline const size_t shm_data_offset = 4096;           // 数据区起始偏移（控制区独占一页）
+
+/**
+ * @brief 共享内存中单个方向的环形缓冲控制区
+ * @note head/tail为累计字节数，只增不减；分属生产者与消费者，各占一个缓存行避免伪共享
+ */
+struct ShmRingHeader
+{
+    alignas(64) std::atomic<uint64_t> head;           // 生产者已写入的字节数
+    alignas(64) std::atomic<uint64_t> tail;           // 消费者已读取的字节数
+    alignas(64) std::atomic<uint32_t> writer_waiting; // 生产者因环满在等待空间
+    std::atomic<uint32_t> closed;                     // 生产者一端已关闭
+};
+
+/**
+ * 共享内存段布局：
+ *   [0, 4096)        控制区：ShmSegmentHeader
+ *   [4096, +ring)    rings[0]的数据：客户端 -> 服务端（请求）
+ *   [+ring, +2*ring) rings[1]的数据：服务端 -> 客户端（响应）
+ */
+struct ShmSegmentHeader
+{
+    uint32_t magic;
+    uint32_t version;
+    uint64_t ring_bytes;      // 每个环的容量
+    ShmRingHeader rings[2];
+};
+static_assert(sizeof(ShmSegmentHeader) <= shm_data_offset, "shm control block exceeds one page");
+
+// 握手消息：随消息经SCM_RIGHTS传递memfd、客户端通知eventfd、服务端通知eventfd
+struct ShmHello
+{
+    uint32_t magic;
+    uint32_t version;
+    uint64_t ring_bytes;
+};
+
+/**
+ * @brief 单生产者单消费者字节环（共享内存视图，不拥有内存）
+ * @note 只在环由空变为非空、或消费者为等待中的生产者腾出空间时才需要通知对端：
+ *       生产者发布head后检查tail，消费者发布tail后重新检查head（双方之间有全序屏障），
+ *       两者至少有一方看到对方的更新，因此不会丢失唤醒。
+ *       head/tail位于对端可写的共享内存中，每次读取都校验 head - tail <= 容量，
+ *       违反时环被标记为损坏，不再读写
+ */
+class ShmRing
+{
+public:
+    ShmRing(ShmRingHeader *hdr = nullptr, char *data = nullptr, uint64_t cap = 0)
+        : hdr_(hdr), data_(data), mask_(cap - 1), corrupt_(false) {}
+
+    /**
+     * @brief 写入尽可能多的数据
+     * @param notify 置为true表示写入前环为空（或曾为空），需要通知消费者
+     * @return 写入的字节数；环满时登记等待，消费者腾出空间后通知；环损坏时返回0
+     */
+    size_t Write(const char *data, size_t len, bool &notify)
+    {
+        notify = false;
+        if (corrupt_) return 0;
+        uint64_t head = hdr_->head.load(std::memory_order_relaxed);
+        size_t written = 0;
+        while (written < len)
+        {
+            uint64_t tail = hdr_->tail.load(std::memory_order_acquire);
+            if (!Valid(head, tail)) break;
+            size_t space = mask_ + 1 - (head - tail);
+            if (space == 0)
+            {
+                // 登记等待后再看一次，避免消费者恰好在登记前取走数据而漏掉通知
+                hdr_->writer_waiting.store(1, std::memory_order_seq_cst);
+                if (hdr_->tail.load(std::memory_order_seq_cst) == tail) break;
+                continue;
+            }
+            size_t n = std::min(space, len - written);
+            Copy(head, data + written, n);
+            hdr_->head.store(head + n, std::memory_order_seq_cst);
+            if (hdr_->tail.load(std::memory_order_seq_cst) == head) notify = true;
+            head += n;
+            written += n;
+        }
+        return written;
+    }
+
+    /**
+     * @brief 取出全部可读数据追加到out
+     * @param notify 置为true表示生产者在等待空间，需要通知它
+     * @return 读取的字节数；环损坏时停止读取
+     */
+    template <typename Out>
+    size_t Read(Out &out, bool &notify)
+    {
+        notify = false;
+        if (corrupt_) return 0;
+        uint64_t tail = hdr_->tail.load(std::memory_order_relaxed);
+        size_t total = 0;
+        while (true)
+        {
+            uint64_t head = hdr_->head.load(std::memory_order_seq_cst);
+            if (head == tail || !Valid(head, tail)) break;
+            size_t n = head - tail;
+            size_t pos = tail & mask_;
+            size_t first = std::min(n, (size_t)(mask_ + 1 - pos));
+            out.append(data_ + pos, first);
+            if (first < n) out.append(data_, n - first);
+            tail = head;
+            total += n;
+            hdr_->tail.store(tail, std::memory_order_seq_cst);
+        }
+        if (total && hdr_->writer_waiting.load(std::memory_order_seq_cst))
+            notify = hdr_->writer_waiting.exchange(0, std::memory_order_seq_cst) != 0;
+        return total;
+    }
+
+    /// 可读字节数
+    size_t Readable()
+    {
+        return hdr_->head.load(std::memory_order_acquire) - hdr_->tail.load(std::memory_order_relaxed);
+    }
+
+    /// head/tail曾违反不变式（对端写坏了控制区）
+    bool Corrupt() { return corrupt_; }
+
+    /// 标记生产者一端已关闭
+    void MarkClosed() { hdr_->closed.store(1, std::memory_order_release); }
+
+    /// 生产者一端是否已关闭
+    bool Closed() { return hdr_->closed.load(std::memory_order_acquire) != 0; }
+
+private:
+    // 校验 head - tail <= 容量（无符号，head落后于tail时同样越界）
+    bool Valid(uint64_t head, uint64_t tail)
+    {
+        if (head - tail <= mask_ + 1) return true;
+        corrupt_ = true;
+        return false;
+    }
+
+    // 从逻辑位置pos开始写入，跨越末尾时回绕
+    void Copy(uint64_t pos, const char *src, size_t n)
+    {
+        size_t off = pos & mask_;
+        size_t first = std::min(n, (size_t)(mask_ + 1 - off));
+        memcpy(data_ + off, src, first);
+        if (first < n) memcpy(data_, src + first, n - first);
+    }
+
+    ShmRingHeader *hdr_;
+    char *data_;
+    uint64_t mask_;
+    bool corrupt_; // 本端视图的状态，不在共享内存中
+};
+
+/**
+ * @brief 同机客户端的共享内存传输通道
+ * @note 服务端在Unix域stream连接上握手：创建memfd承载一对SPSC字节环和两个eventfd，
+ *       经SCM_RIGHTS交给客户端后关闭该socket。此后请求与响应（仍是"长度\n内容\n"帧）
+ *       只经共享内存传递，每个方向仅在环由空变为非空时写一次对端的eventfd。
+ *       没有socket可感知对端崩溃，异常退出的客户端由空闲超时回收
+ */
+class ShmChannel : public nocopy
+{
+public:
+    /**
+     * @brief 服务端：在已accept的Unix域socket上完成握手（不关闭sock）
+     * @return 失败时返回空
+     */
+    static std::shared_ptr<ShmChannel> Accept(int sock, size_t ring_bytes = default_shm_ring_bytes)
+    {
+        if (ring_bytes == 0 || (ring_bytes & (ring_bytes - 1)))
+        {
+            lg(Error, "shm ring size %lu is not a power of two", ring_bytes);
+            return nullptr;
+        }
+        size_t size = shm_data_offset + 2 * ring_bytes;
+        int memfd = memfd_create("reactor_shm", MFD_CLOEXEC);
+        if (memfd == -1 || ftruncate(memfd, size) == -1)
+        {
+            lg(Error, "create shm segment false, errno: %d, errstr: %s", errno, strerror(errno));
+            if (memfd != -1) close(memfd);
+            return nullptr;
+        }
+        void *base = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, memfd, 0);
+        if (base == MAP_FAILED)
+        {
+            lg(Error, "mmap shm segment false, errno: %d, errstr: %s", errno, strerror(errno));
+            close(memfd);
+            return nullptr;
+        }
+        ShmSegmentHeader *seg = new (base) ShmSegmentHeader();
+        seg->magic = shm_magic;
+        seg->version = shm_version;
+        seg->ring_bytes = ring_bytes;
+
+        int local = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        int peer = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        std::shared_ptr<ShmChannel> channel(new ShmChannel(base, size, ring_bytes, 0, local, peer));
+        ShmHello hello{shm_magic, shm_version, ring_bytes};
+        int fds[3] = {memfd, peer, local}; // 客户端视角：段、本端通知fd、对端通知fd
+        bool ok = local != -1 && peer != -1 && SendFds(sock, &hello, sizeof(hello), fds, 3);
+        close(memfd); // 映射保持有效
+        if (!ok)
+        {
+            lg(Error, "shm handshake false, errno: %d, errstr: %s", errno, strerror(errno));
+            return nullptr;
+        }
+        return channel;
+    }
+
+    /**
+     * @brief 客户端：连接服务端的共享内存握手socket（阻塞）
+     * @return 失败时返回空
+     */
+    static std::shared_ptr<ShmChannel> Connect(const std::string &path)
+    {
+        int sock = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        struct sockaddr_un addr;
+        memset(&addr, 0, sizeof(addr));
+        addr.sun_family = AF_UNIX;
+        strncpy(addr.sun_path, path.c_str(), sizeof(addr.sun_path) - 1);
+        if (sock == -1 || connect(sock, (struct sockaddr *)&addr, sizeof(addr)) == -1)
+        {
+            lg(Error, "connect shm socket %s false, errno: %d, errstr: %s", path.c_str(), errno, strerror(errno));
+            if (sock != -1) close(sock);
+            return nullptr;
+        }
+        ShmHello hello;
+        int fds[3] = {-1, -1, -1};
+        bool ok = RecvFds(sock, &hello, sizeof(hello), fds, 3);
+        close(sock);
+        if (!ok || hello.magic != shm_magic || hello.version != shm_version)
+        {
+            lg(Error, "bad shm handshake from %s", path.c_str());
+            for (int fd : fds)
+                if (fd != -1) close(fd);
+            return nullptr;
+        }
+        size_t size = shm_data_offset + 2 * hello.ring_bytes;
+        struct stat st;
+        void *base = MAP_FAILED;
+        if (hello.ring_bytes && !(hello.ring_bytes & (hello.ring_bytes - 1)) &&
+            fstat(fds[0], &st) == 0 && (size_t)st.st_size >= size)
+            base = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fds[0], 0);
+        close(fds[0]);
+        if (base == MAP_FAILED)
+        {
+            lg(Error, "map shm segment false, errno: %d, errstr: %s", errno, strerror(errno));
+            close(fds[1]);
+            close(fds[2]);
+            return nullptr;
+        }
+        std::shared_ptr<ShmChannel> channel(new ShmChannel(base, size, hello.ring_bytes, 1, fds[1], fds[2]));
+        if (channel->Corrupt())
+        {
+            lg(Error, "shm segment from %s does not match handshake", path.c_str());
+            return nullptr;
+        }
+        return channel;
+    }
+
+    ~ShmChannel() { Close(); }
+
+    /**
+     * @brief 写入发往对端的数据，环满时只写入一部分
+     * @return 写入的字节数；未写完的部分在对端腾出空间、本端通知fd可读后重试
+     */
+    size_t Send(const char *data, size_t len)
+    {
+        bool notify;
+        size_t n = tx_.Write(data, len, notify);
+        if (notify) Notify();
+        return n;
+    }
+
+    /// 取出对端发来的全部数据追加到out，返回字节数
+    template <typename Out>
+    size_t Recv(Out &out)
+    {
+        bool notify;
+        size_t n = rx_.Read(out, notify);
+        if (notify) Notify();
+        return n;
+    }
+
+    /// 对端已关闭且数据已全部取出
+    bool PeerClosed() { return rx_.Closed() && rx_.Readable() == 0; }
+
+    /**
+     * @brief 通道是否已损坏：段头与握手时的容量不符，或对端写坏了环的head/tail
+     * @note 损坏后Send/Recv不再访问数据区，调用方应关闭通道
+     */
+    bool Corrupt()
+    {
+        ShmSegmentHeader *seg = (ShmSegmentHeader *)base_;
+        return !base_ || seg->magic != shm_magic || seg->ring_bytes != ring_bytes_ || rx_.Corrupt() || tx_.Corrupt();
+    }
+
+    /// 本端通知fd：对端写入数据或腾出空间时可读（服务端注册到Epoll）
+    int NotifyFd() { return local_fd_; }
+
+    /// 清零通知计数（使用水平触发poll等待时调用）
+    void ClearNotify()
+    {
+        uint64_t cnt;
+        while (read(local_fd_, &cnt, sizeof(cnt)) > 0);
+    }
+
+    /**
+     * @brief 阻塞等待对端通知（客户端使用）
+     * @return 超时返回false
+     */
+    bool Wait(int timeout_ms)
+    {
+        struct pollfd pfd = {local_fd_, POLLIN, 0};
+        int n = poll(&pfd, 1, timeout_ms);
+        if (n > 0) ClearNotify();
+        return n > 0;
+    }
+
+    /// 标记本端关闭并通知对端，解除映射、关闭通知fd（可重复调用）
+    void Close()
+    {
+        if (!base_) return;
+        tx_.MarkClosed();
+        Notify();
+        munmap(base_, size_);
+        base_ = nullptr;
+        close(local_fd_);
+        close(peer_fd_);
+    }
+
+    /// 已向对端发出的通知次数（每次一个write系统调用）
+    uint64_t Notifies() { return notifies_; }
+
+private:
+    // role 0为服务端（读rings[0]、写rings[1]），1为客户端；
+    // 容量取本端已知的值（服务端创建时的值/握手消息中的值），不信任对端可写的段头
+    ShmChannel(void *base, size_t size, uint64_t cap, int role, int local_fd, int peer_fd)
+        : base_(base), size_(size), ring_bytes_(cap), local_fd_(local_fd), peer_fd_(peer_fd), notifies_(0)
+    {
+        ShmSegmentHeader *seg = (ShmSegmentHeader *)base;
+        char *data = (char *)base + shm_data_offset;
+        ShmRing rings[2] = {ShmRing(&seg->rings[0], data, cap), ShmRing(&seg->rings[1], data + cap, cap)};
+        rx_ = rings[role];
+        tx_ = rings[1 - role];
+    }
+
+    void Notify()
+    {
+        uint64_t one = 1;
+        write(peer_fd_, &one, sizeof(one));
+        ++notifies_;
+    }
+
+    static bool SendFds(int sock, const void *data, size_t len, const int *fds, int nfds)
+    {
+        struct iovec iov = {(void *)data, len};
+        char control[CMSG_SPACE(sizeof(int) * 3)];
+        memset(control, 0, sizeof(control));
+        struct msghdr msg;
+        memset(&msg, 0, sizeof(msg));
+        msg.msg_iov = &iov;
+        msg.msg_iovlen = 1;
+        msg.msg_control = control;
+        msg.msg_controllen = CMSG_SPACE(sizeof(int) * nfds);
+        struct cmsghdr *cmsg = CMSG_FIRSTHDR(&msg);
+        cmsg->cmsg_level = SOL_SOCKET;
+        cmsg->cmsg_type = SCM_RIGHTS;
+        cmsg->cmsg_len = CMSG_LEN(sizeof(int) * nfds);
+        memcpy(CMSG_DATA(cmsg), fds, sizeof(int) * nfds);
+        ssize_t n;
+        do n = sendmsg(sock, &msg, MSG_NOSIGNAL);
+        while (n == -1 && errno == EINTR);
+        return n == (ssize_t)len;
+    }
+
+    static bool RecvFds(int sock, void *data, size_t len, int *fds, int nfds)
+    {
+        struct iovec iov = {data, len};
+        char control[CMSG_SPACE(sizeof(int) * 3)];
+        struct msghdr msg;
+        memset(&msg, 0, sizeof(msg));
+        msg.msg_iov = &iov;
+        msg.msg_iovlen = 1;
+        msg.msg_control = control;
+        msg.msg_controllen = CMSG_SPACE(sizeof(int) * nfds);
+        ssize_t n;
+        do n = recvmsg(sock, &msg, MSG_CMSG_CLOEXEC | MSG_WAITALL);
+        while (n == -1 && errno == EINTR);
+        struct cmsghdr *cmsg = CMSG_FIRSTHDR(&msg);
+        if (cmsg && cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SCM_RIGHTS)
+            memcpy(fds, CMSG_DATA(cmsg), std::min<size_t>(cmsg->cmsg_len - CMSG_LEN(0), sizeof(int) * nfds));
+        return n == (ssize_t)len && fds[nfds - 1] != -1;
+    }
+
+    void *base_;       // 共享内存段
+    size_t size_;      // 段大小
+    uint64_t ring_bytes_; // 每个环的容量
+    ShmRing rx_;       // 对端 -> 本端
+    ShmRing tx_;       // 本端 -> 对端
+    int local_fd_;     // 本端通知eventfd
+    int peer_fd_;      // 对端通知eventfd
+    uint64_t notifies_; // 发出的通知次数
+};
+
+#endif
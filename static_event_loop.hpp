@@ -0,0 +1,322 @@
+#ifndef _STATIC_EVENT_LOOP_HPP_
+#define _STATIC_EVENT_LOOP_HPP_ 1
+
+#include <memory>
+#include <vector>
+#include <atomic>
+#include <utility>
+#include <sys/eventfd.h>
+#include "epoll.hpp"
+#include "log.hpp"
+#include "nocopy.hpp"
+#include "ring_queue.hpp"
+#include "buffer_pool.hpp"
+#include "admission.hpp"
+#include "timer_manager.hpp"
+#include "event_loop.hpp"
+#include "trace.hpp"
+
+/**
+ * @brief 编译期特化的事件循环
+ * @tparam Handler 请求处理器：codec的response_t operator()(const request_t &)
+ * @tparam Codec 编解码器，需提供request_t、response_t、state_t（每连接解码状态）及
+ *         Decode(in, state, req)、Consume(in, state)、Encode(resp, out)、Release(state)
+ * @note 与EventLoop相比，读写路径上没有std::function回调、shared_ptr/weak_ptr转换和
+ *       哈希表查找：连接按fd下标存放，处理器和编解码器随模板实例化内联进读路径。
+ *       只支持TCP/Unix域stream连接的请求-响应处理，不支持文件发送、协程与自定义fd；
+ *       空闲连接按秒级粗粒度扫描超时
+ */
+template <typename Handler, typename Codec>
+class StaticEventLoop : public nocopy
+{
+public:
+    using request_t = typename Codec::request_t;
+    using response_t = typename Codec::response_t;
+    using state_t = typename Codec::state_t;
+
+    // 连接状态，缓冲区内存来自本循环的缓冲池
+    struct Conn
+    {
+        Conn(int sock, BufferPool *pool)
+            : fd(sock), addr(INADDR_ANY), port(0), family(AF_INET),
+              write_care(false), last_active(0), in(pool), out(pool) {}
+
+        int fd;               // 套接字文件描述符
+        uint32_t addr;        // 客户端IPv4地址（网络字节序）
+        uint16_t port;        // 客户端端口号
+        sa_family_t family;   // 地址族：AF_INET或AF_UNIX
+        bool write_care;      // 是否关注写事件
+        int64_t last_active;  // 最近一次读写的时间（steady时钟毫秒）
+        buffer_t in;          // 输入缓冲区
+        buffer_t out;         // 输出缓冲区
+        state_t state;        // 解码状态
+    };
+
+    // rq: 新连接队列（可为空），每轮取一个连接，与TaskPush一致
+    explicit StaticEventLoop(std::shared_ptr<RingQueue<ClientInf>> rq = nullptr,
+                             Handler handler = Handler(), Codec codec = Codec())
+        : rq_(rq),
+          handler_(std::move(handler)),
+          codec_(std::move(codec)),
+          pool_(new BufferPool()),
+          recvs_(min_event_batch),
+          idle_ms_((int64_t)default_alive_gap * 1000),
+          next_sweep_(0),
+          count_(0),
+          quit_(false)
+    {
+        wakeup_fd_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        epoller_.EpollCtl(EPOLL_CTL_ADD, wakeup_fd_, EPOLLIN | EPOLLET);
+        if(rq_ && rq_->NotifyFd() >= 0)
+            epoller_.EpollCtl(EPOLL_CTL_ADD, rq_->NotifyFd(), EPOLLIN | EPOLLEXCLUSIVE);
+    }
+
+    ~StaticEventLoop()
+    {
+        for(auto &conn : conns_)
+            if(conn) close(conn->fd);
+        close(wakeup_fd_);
+    }
+
+    // 添加已连接的非阻塞socket，返回的指针在连接关闭前有效
+    Conn *AddConnection(int sock, uint32_t ip = INADDR_ANY, uint16_t port = 0, sa_family_t family = AF_INET)
+    {
+        if((size_t)sock >= conns_.size()) conns_.resize(sock + 1);
+        conns_[sock].reset(new Conn(sock, pool_.get()));
+        Conn *conn = conns_[sock].get();
+        conn->addr = ip;
+        conn->port = port;
+        conn->family = family;
+        conn->last_active = EventLoop::NowMs();
+        ++count_;
+        epoller_.EpollCtl(EPOLL_CTL_ADD, sock, EPOLLIN | EPOLLET);
+        return conn;
+    }
+
+    // 关闭连接并释放其状态
+    void Close(Conn *conn)
+    {
+        int fd = conn->fd;
+        epoller_.EpollCtl(EPOLL_CTL_DEL, fd, 0);
+        close(fd);
+        if(admission_ && conn->family == AF_INET)
+            admission_->ReleaseConnection(conn->addr);  // 归还来源IP的连接计数
+        conns_[fd].reset();
+        --count_;
+    }
+
+    // 事件分发器，返回本轮就绪事件数量
+    int DisPatcher()
+    {
+        int timeout = NextTimeout();
+        int n;
+        {
+            TraceScope trace("epoll_wait", "timeout", timeout);
+            n = epoller_.EpollWait(recvs_.data(), recvs_.size(), timeout);
+            trace.Arg1("events", n);
+        }
+        now_ms_ = EventLoop::NowMs();
+        for(int i = 0; i < n; ++i)
+        {
+            uint32_t events = recvs_[i].events;
+            int sockfd = recvs_[i].data.fd;
+            if(sockfd == wakeup_fd_)
+            {
+                uint64_t cnt;
+                while(read(wakeup_fd_, &cnt, sizeof(cnt)) > 0);
+                continue;
+            }
+            if(rq_ && sockfd == rq_->NotifyFd())
+            {
+                uint64_t cnt;
+                read(sockfd, &cnt, sizeof(cnt));
+                continue;
+            }
+            if((size_t)sockfd >= conns_.size() || !conns_[sockfd]) continue;
+            Conn *conn = conns_[sockfd].get();
+            TraceScope trace("dispatch", "fd", sockfd, "events", events);
+
+            if(events & (EPOLLERR | EPOLLHUP)) events |= (EPOLLIN | EPOLLOUT);
+            if(events & EPOLLIN && !Recv(conn)) continue;  // 连接已关闭
+            if(events & EPOLLOUT && conn->write_care && !Send(conn)) continue;
+            conn->last_active = now_ms_;
+            ReleaseIdleBuffers(conn);
+        }
+        if((size_t)n == recvs_.size() && recvs_.size() < max_event_batch) recvs_.resize(recvs_.size() * 2);
+        return n;
+    }
+
+    // 主事件循环
+    void Loop()
+    {
+        while(!quit_)
+        {
+            if(rq_)
+            {
+                if(auto client_inf = rq_->Pop())
+                    AddConnection(client_inf->sockfd, client_inf->client_ip,
+                                  client_inf->client_port, client_inf->family);
+            }
+            DisPatcher();
+            ExpireIdle();
+        }
+    }
+
+    // 请求事件循环在本轮结束后退出（线程安全）
+    void Stop()
+    {
+        quit_ = true;
+        uint64_t one = 1;
+        write(wakeup_fd_, &one, sizeof(one));
+    }
+
+    /// 设置空闲连接超时时间（秒），0表示不超时
+    void SetIdleTimeout(int seconds) { idle_ms_ = (int64_t)seconds * 1000; }
+
+    /// 设置准入控制（与Listener共用同一实例），语义同EventLoop::SetAdmission
+    void SetAdmission(std::shared_ptr<AdmissionControl> admission) { admission_ = admission; }
+
+    /// 当前连接数
+    size_t ConnectionCount() { return count_; }
+
+    /// 缓冲池统计（仅限本线程读取）
+    BufferPoolStats BufferStats() { return pool_->Stats(); }
+
+private:
+    // 读取全部可读数据后解码、处理并编码响应，连接关闭时返回false
+    bool Recv(Conn *conn)
+    {
+        while(true)
+        {
+            ssize_t n = recv(conn->fd, buffer, sizeof(buffer), 0);
+            if(n > 0)
+            {
+                conn->in.append(buffer, n);
+            }
+            else if(n == 0)
+            {
+                lg(Info, "client [%d] quit", conn->fd);
+                Close(conn);
+                return false;
+            }
+            else
+            {
+                if(errno == EWOULDBLOCK) break;
+                else if(errno == EINTR) continue;
+                lg(Error, "recv from client [%d] false", conn->fd);
+                Close(conn);
+                return false;
+            }
+        }
+
+        // 先解码全部完整请求，按请求数扣减令牌后再处理，超限的请求不消耗计算
+        size_t decoded = 0;
+        while(true)
+        {
+            if(decoded == reqs_.size()) reqs_.emplace_back();
+            if(!codec_.Decode(conn->in, conn->state, reqs_[decoded])) break;
+            ++decoded;
+        }
+        codec_.Consume(conn->in, conn->state);
+        if(decoded == 0) return true;
+        size_t admitted = decoded;
+        if(admission_ && conn->family == AF_INET) admitted = admission_->AdmitRequests(conn->addr, decoded);
+        for(size_t i = 0; i < admitted; ++i)
+            codec_.Encode(handler_(reqs_[i]), conn->out);
+
+        // 请求速率超限：尽力发出放行部分的响应后断开，与MessageHandler一致
+        if(admitted < decoded)
+        {
+            lg(Warning, "client [%d] request rate exceeded", conn->fd);
+            if(Send(conn)) Close(conn);
+            return false;
+        }
+        return Send(conn);
+    }
+
+    // 发送输出缓冲区，未发完时关注写事件，出错关闭连接时返回false
+    bool Send(Conn *conn)
+    {
+        buffer_t &out = conn->out;
+        size_t sent = 0;
+        while(sent < out.size())
+        {
+            ssize_t n = send(conn->fd, out.data() + sent, out.size() - sent, MSG_NOSIGNAL);
+            if(n > 0) sent += n;
+            else if(n < 0 && errno == EWOULDBLOCK) break;
+            else if(n < 0 && errno == EINTR) continue;
+            else
+            {
+                lg(Error, "send to client [%d] false", conn->fd);
+                Close(conn);
+                return false;
+            }
+        }
+        out.erase(0, sent);
+
+        bool pending = !out.empty();
+        if(pending != conn->write_care)
+        {
+            epoller_.EpollCtl(EPOLL_CTL_MOD, conn->fd, pending ? (EPOLLIN | EPOLLOUT | EPOLLET) : (EPOLLIN | EPOLLET));
+            conn->write_care = pending;
+        }
+        return true;
+    }
+
+    // 空闲缓冲区归还缓冲池，规则同Connection::ReleaseIdleBuffers
+    void ReleaseIdleBuffers(Conn *conn)
+    {
+        Shrink(conn->in);
+        Shrink(conn->out);
+        if(conn->in.empty()) codec_.Release(conn->state);
+    }
+
+    static void Shrink(buffer_t &buf)
+    {
+        if(buf.empty() || (buf.capacity() > buffer_keep_bytes && buf.size() * 4 < buf.capacity()))
+            buf.shrink_to_fit();
+    }
+
+    // 每秒扫描一次连接表，关闭超时未活动的连接
+    void ExpireIdle()
+    {
+        if(idle_ms_ <= 0 || now_ms_ < next_sweep_) return;
+        next_sweep_ = now_ms_ + 1000;
+        for(auto &conn : conns_)
+        {
+            if(conn && now_ms_ - conn->last_active >= idle_ms_)
+            {
+                lg(Info, "client [%d] idle timeout", conn->fd);
+                Close(conn.get());
+            }
+        }
+    }
+
+    // 有空闲超时时最多等到下一次扫描
+    int NextTimeout()
+    {
+        int timeout = epoller_.Timeout();
+        if(idle_ms_ <= 0 || count_ == 0) return timeout;
+        int64_t wait = next_sweep_ - now_ms_;
+        if(wait <= 0) return 0;
+        return wait < timeout ? (int)wait : timeout;
+    }
+
+    std::shared_ptr<RingQueue<ClientInf>> rq_;  // 新连接队列
+    Handler handler_;                            // 请求处理器
+    Codec codec_;                                // 编解码器
+    std::vector<request_t> reqs_;                // 本批解码出的请求（复用）
+    Epoll epoller_;                              // epoll实例
+    std::unique_ptr<BufferPool> pool_;           // 连接缓冲池（须先于连接构造、后于连接析构）
+    std::vector<std::unique_ptr<Conn>> conns_;   // 按fd下标存放的连接
+    std::vector<struct epoll_event> recvs_;      // epoll事件数组（只增不减）
+    std::shared_ptr<AdmissionControl> admission_; // 准入控制（可为空）
+    int64_t idle_ms_;                            // 空闲超时（毫秒），0表示不超时
+    int64_t next_sweep_;                         // 下一次空闲扫描的时间
+    int64_t now_ms_ = 0;                         // 本轮开始时间（steady时钟毫秒）
+    size_t count_;                               // 当前连接数
+    int wakeup_fd_;                              // 跨线程唤醒用eventfd
+    std::atomic<bool> quit_;                     // 退出标志
+};
+
+#endif
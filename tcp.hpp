@@ -4,7 +4,9 @@
 #include <iostream>
 #include <sys/socket.h>
 #include <netinet/in.h>
+#include <netinet/tcp.h>
 #include <arpa/inet.h>
+#include <sys/un.h>
 #include <cstring>
 #include "log.hpp"
 
@@ -17,14 +19,37 @@ enum
 };
 
 inline thread_local char addr_buffer[1024];
+inline const int default_backlog = SOMAXCONN; // 默认全连接队列长度
+
+/**
+ * @brief socket选项配置
+ * @note 监听类选项在Listener初始化时设置一次，
+ *       连接类选项在每个新连接accept后设置
+ */
+struct SockOpts
+{
+    // 监听socket选项
+    bool reuse_addr = true; // SO_REUSEADDR，重启时无需等待TIME_WAIT
+    bool reuse_port = false; // SO_REUSEPORT，多个socket绑定同一端口由内核分流
+    int defer_accept = 0;   // TCP_DEFER_ACCEPT（秒），有数据到达才唤醒accept，0为关闭
+
+    // 连接socket选项
+    bool nodelay = true;    // TCP_NODELAY，关闭Nagle算法
+    bool keepalive = false; // SO_KEEPALIVE
+    int rcvbuf = 0;         // SO_RCVBUF（字节），0保持系统默认
+    int sndbuf = 0;         // SO_SNDBUF（字节），0保持系统默认
+    int busy_poll = 0;      // SO_BUSY_POLL（微秒），阻塞读时在网卡队列上忙轮询，0为关闭
+};
 
 class Sock
 {
 public:
     Sock() {}
-    void Socket()
+    // type可附加SOCK_NONBLOCK，如 SOCK_DGRAM | SOCK_NONBLOCK
+    // domain为AF_INET或AF_UNIX
+    void Socket(int type = SOCK_STREAM, int domain = AF_INET)
     {
-        sockfd_ = socket(AF_INET, SOCK_STREAM, 0);
+        sockfd_ = socket(domain, type | SOCK_CLOEXEC, 0);
         if (sockfd_ == -1)
         {
             perror("socket");
@@ -45,7 +70,27 @@ public:
             exit(bind_error);
         }
     }
-    void Listen(int backlog = 10)
+    // 绑定Unix域socket路径（先删除残留的socket文件）
+    void BindUnix(const std::string &path)
+    {
+        struct sockaddr_un local;
+        bzero(&local, sizeof(local));
+        local.sun_family = AF_UNIX;
+        if (path.size() >= sizeof(local.sun_path))
+        {
+            lg(Fatal, "unix socket path too long: %s", path.c_str());
+            exit(bind_error);
+        }
+        strncpy(local.sun_path, path.c_str(), sizeof(local.sun_path) - 1);
+        unlink(path.c_str());
+        int n = bind(sockfd_, (struct sockaddr *)(&local), sizeof(local));
+        if (n != 0)
+        {
+            perror("bind");
+            exit(bind_error);
+        }
+    }
+    void Listen(int backlog = default_backlog)
     {
         int n = listen(sockfd_, backlog);
         if (n == -1)
@@ -66,6 +111,53 @@ public:
     int GetSockfd(){ return sockfd_; }
 
 public:
+    // 设置监听socket选项（须在Bind之前调用）
+    static void ApplyListenOpts(int sockfd, const SockOpts &opts)
+    {
+        int on = 1;
+        if (opts.reuse_addr)
+            SetOpt(sockfd, SOL_SOCKET, SO_REUSEADDR, on);
+        if (opts.reuse_port)
+            SetOpt(sockfd, SOL_SOCKET, SO_REUSEPORT, on);
+        if (opts.defer_accept > 0)
+            SetOpt(sockfd, IPPROTO_TCP, TCP_DEFER_ACCEPT, opts.defer_accept);
+    }
+
+    // 设置已连接socket选项
+    static void ApplyConnOpts(int sockfd, const SockOpts &opts)
+    {
+        int on = 1;
+        if (opts.nodelay)
+            SetOpt(sockfd, IPPROTO_TCP, TCP_NODELAY, on);
+        if (opts.keepalive)
+            SetOpt(sockfd, SOL_SOCKET, SO_KEEPALIVE, on);
+        if (opts.rcvbuf > 0)
+            SetOpt(sockfd, SOL_SOCKET, SO_RCVBUF, opts.rcvbuf);
+        if (opts.sndbuf > 0)
+            SetOpt(sockfd, SOL_SOCKET, SO_SNDBUF, opts.sndbuf);
+        if (opts.busy_poll > 0)
+        {
+            // 超过net.core.busy_read的值需要CAP_NET_ADMIN
+            SetOpt(sockfd, SOL_SOCKET, SO_BUSY_POLL, opts.busy_poll);
+            SetOpt(sockfd, SOL_SOCKET, SO_PREFER_BUSY_POLL, on);
+        }
+    }
+
+    static void SetOpt(int sockfd, int level, int name, int value)
+    {
+        if (setsockopt(sockfd, level, name, &value, sizeof(value)) == -1)
+            lg(Warning, "setsockopt(%d, %d) false, errno: %d, errstr: %s", level, name, errno, strerror(errno));
+    }
+
+    // 将IPv4地址格式化到调用方提供的缓冲区，不分配内存
+    static const char *AddrToStr(uint32_t addr, char *buf, socklen_t len)
+    {
+        struct in_addr in;
+        in.s_addr = addr;
+        inet_ntop(AF_INET, &in, buf, len);
+        return buf;
+    }
+
     static void GetAddrAndPort(struct sockaddr_in &addr_in, std::string &addr, uint16_t &port)
     {
         port = ntohs(addr_in.sin_port);
@@ -23,10 +23,12 @@ struct Timer
     Timer(int expired_time_, int cnt_, std::shared_ptr<Connection> connect_)
     :expired_time(expired_time_),  // 绝对过期时间戳
     cnt(cnt_),                     // 连续活跃次数计数器
+    in_heap(false),                // 尚未放入最小堆
     connect(connect_){}            // 管理的连接对象
     
     int expired_time;              // Unix时间戳格式的过期时间
     int cnt;                       // 累计活跃次数（用于奖励机制）
+    bool in_heap;                  // 是否已在最小堆中（在堆中则不能原地修改过期时间）
     std::shared_ptr<Connection> connect; // 关联的连接智能指针
 };
 
@@ -27,36 +27,71 @@ public:
     {
         // 创建新定时器（当前时间+存活周期）
         std::shared_ptr<Timer> timer(new Timer(std::time(nullptr) + alive_gap, 0, connect));
+        timer->in_heap = true;
         timers.emplace(timer);                // 插入最小堆
         timer_map[connect->Sockfd()] = timer; // 建立socket到定时器的映射
     }
 
+    /**
+     * @brief 以给定的过期时间和活跃计数添加连接（迁入的连接保留原有定时器状态）
+     */
+    void Push(std::shared_ptr<Connection> connect, int expired_time, int cnt)
+    {
+        std::shared_ptr<Timer> timer(new Timer(expired_time, cnt, connect));
+        timer->in_heap = true;
+        timers.emplace(timer);
+        timer_map[connect->Sockfd()] = timer;
+    }
+
+    /**
+     * @brief 取出连接的定时器状态并删除（连接迁往其他事件循环时调用）
+     * @return 连接不受定时器管理（如监听socket）时返回false
+     */
+    bool Take(int sockfd, int &expired_time, int &cnt)
+    {
+        auto iter = timer_map.find(sockfd);
+        if (iter == timer_map.end()) return false;
+        expired_time = iter->second->expired_time;
+        cnt = iter->second->cnt;
+        timer_map.erase(iter); // 堆中的旧定时器惰性删除
+        return true;
+    }
+
     /**
      * @brief 检查堆顶是否过期
      * @return true表示存在过期连接需要处理
      */
     bool IsTopExpired()
     {
-        while (!timers.empty() && timers.top()->expired_time <= std::time(nullptr))
+        int now = std::time(nullptr);
+        while (!timers.empty() && timers.top()->expired_time <= now)
         {
-            int sockfd = (timers.top()->connect)->Sockfd();
-            // 处理惰性删除
-            if(timer_map.find(sockfd) == timer_map.end()) {
+            auto top = timers.top();
+            auto iter = timer_map.find(top->connect->Sockfd());
+            // 处理惰性删除：连接已关闭，或fd已被新连接复用
+            if (iter == timer_map.end() || iter->second->connect != top->connect)
+            {
                 timers.pop();
                 continue;
             }
-            if(timers.top()->cnt != timer_map[sockfd]->cnt || timers.top()->expired_time != timer_map[sockfd]->expired_time)
+            auto &current = iter->second;
+            if (current != top)
             {
+                // 连接期间活跃过，改用最新的定时器
                 timers.pop();
-                timers.emplace(timer_map[sockfd]);
+                if (!current->in_heap)
+                {
+                    current->in_heap = true;
+                    timers.emplace(current);
+                }
             }
-            else if (timers.top()->cnt >= 5)
+            else if (top->cnt >= alive_cnt)
             {
-                auto timer = timers.top();
-                timer->expired_time = std::time(nullptr) + alive_gap;
-                timer->cnt = 0;
-                timers.emplace(timer);
-                timer_map[sockfd] = timer;
+                // 活跃次数达到阈值，奖励续期一次（先出堆再修改，保持堆序）
+                timers.pop();
+                top->expired_time = now + alive_gap;
+                top->cnt = 0;
+                timers.emplace(top);
             }
             else
             {
@@ -80,23 +115,35 @@ public:
     /**
      * @brief 更新连接活跃时间
      * @param sockfd 要更新的socket描述符
+     * @note 堆中元素不能原地修改，仅当映射中的定时器已在堆中时才新建一个；
+     *       之后的更新直接修改这个尚未入堆的定时器，每个过期周期最多一次分配
      */
     void UpdateTime(int sockfd)
     {
         // 检测链接是否已被删除
-        if(timer_map.find(sockfd) == timer_map.end()) return;
-        if(timers.empty()) return;
-        // 创建新的 Timer（避免共享指针副作用）
-        auto new_timer = std::make_shared<Timer>(
-        std::time(nullptr) + alive_gap,
-        timer_map[sockfd]->cnt + 1,
-        timer_map[sockfd]->connect
-        );
+        auto iter = timer_map.find(sockfd);
+        if(iter == timer_map.end()) return;
+        auto &timer = iter->second;
+        int expired_time = std::time(nullptr) + alive_gap;
+        if(!timer->in_heap)
+        {
+            timer->expired_time = expired_time; // 重置过期时间
+            timer->cnt++;                       // 增加活跃计数
+            return;
+        }
+        timer = std::make_shared<Timer>(expired_time, timer->cnt + 1, timer->connect);
+    }
 
-        // 更新 timer_map
-        timer_map[sockfd] = new_timer;
-        timer_map[sockfd]->cnt++;       // 增加活跃计数
-        timer_map[sockfd]->expired_time = time(nullptr) + alive_gap; // 重置过期时间
+    /// 预留容量，避免海量连接时哈希表反复扩容
+    void Reserve(size_t n)
+    {
+        timer_map.reserve(n);
+    }
+
+    /// 设置存活周期（秒），只影响之后创建或续期的定时器
+    void SetGap(int gap)
+    {
+        alive_gap = gap;
     }
 
 private:
@@ -0,0 +1,185 @@
+#ifndef _TIMER_QUEUE_HPP_
+#define _TIMER_QUEUE_HPP_ 1
+
+#include <vector>
+#include <algorithm>
+#include <functional>
+#include <utility>
+#include <cstdint>
+#include "nocopy.hpp"
+
+// 定时器ID：低32位为槽位下标，高32位为槽位代数；0表示无效
+using timer_id_t = uint64_t;
+
+/**
+ * @brief 事件循环级的通用定时器队列（毫秒精度）
+ * @note 定时器存放在槽位数组中，最小堆只保存（到期时间，槽位，代数）。
+ *       取消时槽位代数加一并立即复用，堆中的旧条目出堆时因代数不符被跳过；
+ *       失效条目超过一半时整体重建堆，大量取消不会让堆无限增长。
+ *       非线程安全，只能在所属EventLoop线程中使用
+ */
+class TimerQueue : public nocopy
+{
+public:
+    TimerQueue() : seq_(0), live_(0) {}
+
+    /**
+     * @brief 添加定时器
+     * @param when 首次到期时间（steady时钟毫秒）
+     * @param interval 大于0时为周期定时器的间隔（毫秒）
+     */
+    timer_id_t Add(int64_t when, int64_t interval, std::function<void()> cb)
+    {
+        uint32_t idx;
+        if (!free_.empty())
+        {
+            idx = free_.back();
+            free_.pop_back();
+        }
+        else
+        {
+            idx = (uint32_t)slots_.size();
+            slots_.push_back(Slot());
+        }
+        Slot &slot = slots_[idx];
+        slot.cb = std::move(cb);
+        slot.interval = interval;
+        slot.active = true;
+        ++live_;
+        Push({when, seq_++, idx, slot.gen});
+        return MakeId(idx, slot.gen);
+    }
+
+    /**
+     * @brief 取消定时器
+     * @return 定时器仍在等待（或为正在执行的周期定时器）时返回true
+     */
+    bool Cancel(timer_id_t id)
+    {
+        uint32_t idx = (uint32_t)id;
+        uint32_t gen = (uint32_t)(id >> 32);
+        if (idx >= slots_.size() || slots_[idx].gen != gen || !slots_[idx].active) return false;
+        Release(idx);
+        MaybeCompact();
+        return true;
+    }
+
+    /**
+     * @brief 执行所有到期的定时器
+     * @return 执行的回调数
+     */
+    size_t RunExpired(int64_t now)
+    {
+        size_t fired = 0;
+        while (!heap_.empty() && heap_.front().when <= now)
+        {
+            Entry top = Pop();
+            if (slots_[top.idx].gen != top.gen) continue; // 已取消
+            ++fired;
+
+            Slot &slot = slots_[top.idx];
+            int64_t interval = slot.interval;
+            // 回调中可能增删定时器导致槽位数组扩容，先把回调移出
+            std::function<void()> cb = std::move(slot.cb);
+            if (interval <= 0)
+            {
+                Release(top.idx); // 单次定时器在回调前释放，回调中Cancel自身无效
+                cb();
+                continue;
+            }
+
+            cb();
+            Slot &after = slots_[top.idx];
+            if (after.gen != top.gen) continue; // 回调中取消了自身
+            after.cb = std::move(cb);
+            // 按原节拍续期；落后超过一个周期时不补发，从当前时刻重新计时
+            int64_t next = top.when + interval;
+            if (next <= now) next = now + interval;
+            Push({next, seq_++, top.idx, top.gen});
+        }
+        return fired;
+    }
+
+    /// 最近的到期时间，无定时器时返回-1
+    int64_t NextWhen()
+    {
+        while (!heap_.empty() && slots_[heap_.front().idx].gen != heap_.front().gen)
+            Pop(); // 顺带丢弃已取消的堆顶
+        return heap_.empty() ? -1 : heap_.front().when;
+    }
+
+    /// 等待中的定时器数量
+    size_t Size() const { return live_; }
+
+    /// 堆中的条目数（含尚未清理的已取消条目）
+    size_t HeapSize() const { return heap_.size(); }
+
+private:
+    struct Slot
+    {
+        std::function<void()> cb; // 回调
+        int64_t interval = 0;     // 周期（毫秒），0为单次
+        uint32_t gen = 1;         // 代数，每次释放加一
+        bool active = false;      // 是否在使用
+    };
+
+    struct Entry
+    {
+        int64_t when;  // 到期时间
+        uint64_t seq;  // 添加顺序，同一时刻到期的按添加顺序执行
+        uint32_t idx;  // 槽位下标
+        uint32_t gen;  // 入堆时的槽位代数
+
+        bool operator>(const Entry &other) const
+        {
+            return when != other.when ? when > other.when : seq > other.seq;
+        }
+    };
+
+    static timer_id_t MakeId(uint32_t idx, uint32_t gen)
+    {
+        return ((uint64_t)gen << 32) | idx;
+    }
+
+    void Release(uint32_t idx)
+    {
+        Slot &slot = slots_[idx];
+        slot.cb = nullptr;
+        slot.active = false;
+        if (++slot.gen == 0) slot.gen = 1; // 保证ID非0
+        free_.push_back(idx);
+        --live_;
+    }
+
+    void Push(const Entry &e)
+    {
+        heap_.push_back(e);
+        std::push_heap(heap_.begin(), heap_.end(), std::greater<Entry>());
+    }
+
+    Entry Pop()
+    {
+        std::pop_heap(heap_.begin(), heap_.end(), std::greater<Entry>());
+        Entry e = heap_.back();
+        heap_.pop_back();
+        return e;
+    }
+
+    // 失效条目过多时原地过滤并重建堆（线性时间）
+    void MaybeCompact()
+    {
+        if (heap_.size() < 1024 || heap_.size() < live_ * 2) return;
+        heap_.erase(std::remove_if(heap_.begin(), heap_.end(),
+                                   [this](const Entry &e) { return slots_[e.idx].gen != e.gen; }),
+                    heap_.end());
+        std::make_heap(heap_.begin(), heap_.end(), std::greater<Entry>());
+    }
+
+    std::vector<Slot> slots_;     // 槽位数组
+    std::vector<uint32_t> free_;  // 空闲槽位
+    std::vector<Entry> heap_;     // 到期时间最小堆
+    uint64_t seq_;                // 添加序号
+    size_t live_;                 // 等待中的定时器数量
+};
+
+#endif
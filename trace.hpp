@@ -0,0 +1,257 @@
+#ifndef _TRACE_HPP_
+#define _TRACE_HPP_ 1
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <atomic>
+#include <thread>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <csignal>
+#include <pthread.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+#include "log.hpp"
+#include "nocopy.hpp"
+
+inline const size_t default_trace_events = 1 << 16; // 每个线程环形缓冲保留的事件数
+
+// 一条跟踪事件：dur为-1时是瞬时事件
+struct TraceEvent
+{
+    const char *name;   // 事件名（静态字符串）
+    int64_t ts;         // 开始时间（steady时钟纳秒）
+    int64_t dur;        // 持续时间（纳秒）
+    const char *k0;     // 参数名（静态字符串，可为空）
+    int64_t v0;
+    const char *k1;
+    int64_t v1;
+};
+
+/**
+ * @brief 单个线程的跟踪事件环形缓冲
+ * @note 只由所属线程写入，满后覆盖最旧的事件；导出线程读取时按写入序号校验，
+ *       丢弃读取期间可能被覆盖的槽位
+ */
+class TraceRing : public nocopy
+{
+public:
+    TraceRing(size_t cap, std::string name)
+        : events_(cap), head_(0), tid_((int)syscall(SYS_gettid)), name_(std::move(name)) {}
+
+    void Push(const TraceEvent &ev)
+    {
+        uint64_t head = head_.load(std::memory_order_relaxed);
+        events_[head % events_.size()] = ev;
+        head_.store(head + 1, std::memory_order_release);
+    }
+
+    // 复制当前仍有效的事件（可在其他线程调用）
+    void Snapshot(std::vector<TraceEvent> &out)
+    {
+        size_t cap = events_.size();
+        uint64_t head = head_.load(std::memory_order_acquire);
+        uint64_t first = head > cap ? head - cap : 0;
+        size_t base = out.size();
+        for (uint64_t i = first; i < head; ++i) out.push_back(events_[i % cap]);
+        // 复制期间写入方可能覆盖了最旧的若干槽位（含正在写入、尚未发布的一个）
+        uint64_t after = head_.load(std::memory_order_acquire) + 1;
+        uint64_t valid = after > cap ? after - cap : 0;
+        if (valid > first)
+        {
+            size_t drop = std::min<uint64_t>(valid - first, head - first);
+            out.erase(out.begin() + base, out.begin() + base + drop);
+        }
+    }
+
+    int Tid() const { return tid_; }
+    const std::string &Name() const { return name_; }
+    void SetName(const std::string &name) { name_ = name; }
+
+private:
+    std::vector<TraceEvent> events_;
+    std::atomic<uint64_t> head_; // 已写入的事件总数
+    int tid_;                    // 内核线程号
+    std::string name_;           // 线程名（导出时显示）
+};
+
+/**
+ * @brief 事件循环跟踪器（进程内单例，默认关闭）
+ * @note 开启后各线程首次记录时创建自己的环形缓冲；导出为Chrome trace JSON，
+ *       可直接用chrome://tracing或ui.perfetto.dev打开
+ */
+class Tracer : public nocopy
+{
+public:
+    static Tracer &Instance()
+    {
+        static Tracer tracer;
+        return tracer;
+    }
+
+    /// 开启跟踪，events为每个线程保留的最近事件数
+    void Enable(size_t events = default_trace_events)
+    {
+        ring_events_ = events;
+        enabled_.store(true, std::memory_order_relaxed);
+    }
+
+    void Disable() { enabled_.store(false, std::memory_order_relaxed); }
+
+    static bool Enabled() { return enabled_.load(std::memory_order_relaxed); }
+
+    static int64_t Now()
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    /// 记录一条事件到本线程的环形缓冲
+    void Record(const TraceEvent &ev) { Ring()->Push(ev); }
+
+    /// 为当前线程命名（导出后显示在时间线上）
+    void NameThread(const std::string &name)
+    {
+        std::lock_guard<std::mutex> lock(mtx_);
+        name_ = name;
+        if (ring_) ring_->SetName(name);
+    }
+
+    /**
+     * @brief 把所有线程缓冲中的事件写成Chrome trace JSON（可在任意线程调用）
+     * @return 写入的事件数，文件无法打开时返回-1
+     */
+    long Dump(const std::string &path)
+    {
+        std::vector<std::shared_ptr<TraceRing>> rings;
+        {
+            std::lock_guard<std::mutex> lock(mtx_);
+            rings = rings_;
+        }
+        FILE *fp = fopen(path.c_str(), "w");
+        if (!fp)
+        {
+            lg(Error, "open trace file %s false, errno: %d, errstr: %s", path.c_str(), errno, strerror(errno));
+            return -1;
+        }
+        int pid = getpid();
+        long count = 0;
+        bool first = true;
+        fprintf(fp, "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[");
+        std::vector<TraceEvent> events;
+        for (auto &ring : rings)
+        {
+            fprintf(fp, "%s\n{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":%d,\"tid\":%d,\"args\":{\"name\":\"%s\"}}",
+                    first ? "" : ",", pid, ring->Tid(), ring->Name().c_str());
+            first = false;
+            events.clear();
+            ring->Snapshot(events);
+            for (auto &ev : events)
+            {
+                if (ev.dur >= 0)
+                    fprintf(fp, ",\n{\"ph\":\"X\",\"name\":\"%s\",\"pid\":%d,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f",
+                            ev.name, pid, ring->Tid(), ev.ts / 1e3, ev.dur / 1e3);
+                else
+                    fprintf(fp, ",\n{\"ph\":\"i\",\"s\":\"t\",\"name\":\"%s\",\"pid\":%d,\"tid\":%d,\"ts\":%.3f",
+                            ev.name, pid, ring->Tid(), ev.ts / 1e3);
+                if (ev.k0)
+                {
+                    fprintf(fp, ",\"args\":{\"%s\":%ld", ev.k0, (long)ev.v0);
+                    if (ev.k1) fprintf(fp, ",\"%s\":%ld", ev.k1, (long)ev.v1);
+                    fprintf(fp, "}");
+                }
+                fprintf(fp, "}");
+                ++count;
+            }
+        }
+        fprintf(fp, "\n]}\n");
+        fclose(fp);
+        lg(Info, "trace dumped to %s, %ld events from %lu threads", path.c_str(), count, rings.size());
+        return count;
+    }
+
+    /**
+     * @brief 收到信号时导出跟踪（须在创建其他线程之前调用）
+     * @note 在调用线程屏蔽该信号，之后创建的线程继承屏蔽字，由专门的线程sigwait后导出
+     */
+    void DumpOnSignal(int sig, const std::string &path)
+    {
+        sigset_t set;
+        sigemptyset(&set);
+        sigaddset(&set, sig);
+        pthread_sigmask(SIG_BLOCK, &set, nullptr);
+        std::thread([this, set, path]() {
+            int got;
+            while (sigwait(&set, &got) == 0) Dump(path);
+        }).detach();
+    }
+
+private:
+    Tracer() : ring_events_(default_trace_events) {}
+
+    // 本线程的环形缓冲，首次使用时创建并登记
+    TraceRing *Ring()
+    {
+        if (!ring_)
+        {
+            std::lock_guard<std::mutex> lock(mtx_);
+            char name[32];
+            if (name_.empty() && pthread_getname_np(pthread_self(), name, sizeof(name)) == 0) name_ = name;
+            ring_.reset(new TraceRing(ring_events_, name_));
+            rings_.push_back(ring_);
+        }
+        return ring_.get();
+    }
+
+    static inline std::atomic<bool> enabled_{false}; // 是否记录
+    size_t ring_events_;                             // 新建缓冲的容量
+    std::mutex mtx_;                                 // 保护rings_
+    std::vector<std::shared_ptr<TraceRing>> rings_;  // 所有线程的缓冲（线程退出后保留）
+    static inline thread_local std::shared_ptr<TraceRing> ring_; // 本线程的缓冲
+    static inline thread_local std::string name_;                // 本线程的名字
+};
+
+/**
+ * @brief 跟踪区间：构造时计时，析构时记录一条完整事件；跟踪关闭时只有一次原子读
+ * @note name与参数名须为静态字符串
+ */
+class TraceScope : public nocopy
+{
+public:
+    explicit TraceScope(const char *name, const char *k0 = nullptr, int64_t v0 = 0,
+                        const char *k1 = nullptr, int64_t v1 = 0)
+        : ev_{name, Tracer::Enabled() ? Tracer::Now() : 0, 0, k0, v0, k1, v1} {}
+
+    ~TraceScope()
+    {
+        if (ev_.ts == 0) return;
+        ev_.dur = Tracer::Now() - ev_.ts;
+        Tracer::Instance().Record(ev_);
+    }
+
+    /// 设置参数（如区间结束时才知道的结果）
+    void Arg0(int64_t v) { ev_.v0 = v; }
+    void Arg1(const char *k, int64_t v)
+    {
+        ev_.k1 = k;
+        ev_.v1 = v;
+    }
+
+    /// 放弃本次记录（如区间内没有实际工作）
+    void Cancel() { ev_.ts = 0; }
+
+private:
+    TraceEvent ev_;
+};
+
+/// 记录瞬时事件
+inline void TraceInstant(const char *name, const char *k0 = nullptr, int64_t v0 = 0)
+{
+    if (!Tracer::Enabled()) return;
+    Tracer::Instance().Record({name, Tracer::Now(), -1, k0, v0, nullptr, 0});
+}
+
+#endif